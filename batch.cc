@@ -0,0 +1,99 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// the batch is cut into chunks of consecutive polygons, and each worker is
+// dealt an equal run of them up front. a worker that's through with its own
+// run goes on to take chunks from the others, so that a few large polygons
+// can't hold the rest of the batch up. all it takes to hand out a chunk is
+// one atomic increment, and since every chunk knows beforehand where its
+// triangles go, the workers never have to wait for each other
+
+static const size_t chunk_size = 256;
+
+// padded out to keep the queues of different workers off each other's cache
+// lines
+struct chunk_queue
+{
+  std::atomic<size_t> next;
+  size_t end;
+  char padding[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+// calls `work` with every chunk in [0, chunks) exactly once, from `workers`
+// threads including the calling one
+template <typename F>
+static void run_chunks(size_t chunks, unsigned workers, F work) {
+  std::vector<chunk_queue> queues(workers);
+  for (unsigned w = 0; w < workers; w++) {
+    queues[w].next = chunks * w / workers;
+    queues[w].end = chunks * (w + 1) / workers;
+  }
+  auto worker = [&](unsigned w) {
+    for (unsigned k = 0; k < workers; k++) {
+      chunk_queue &q = queues[(w + k) % workers];
+      for (size_t c; (c = q.next.fetch_add(1, std::memory_order_relaxed))
+          < q.end; )
+        work(c);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned w = 1; w < workers; w++)
+    threads.emplace_back(worker, w);
+  worker(0);
+  for (std::thread &t : threads)
+    t.join();
+}
+
+template <typename T>
+size_t triangulate_batch(const vec2<T> *vertices, const uint32_t *ring_starts
+    , size_t polygons, const triangulate_options &options, uint32_t *indices
+    , unsigned threads) {
+  size_t chunks = (polygons + chunk_size - 1) / chunk_size;
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  unsigned workers = (unsigned)std::min<size_t>(threads, chunks);
+  if (workers == 0)
+    return 0;
+
+  // where the triangles of every chunk start. a subtraction per polygon,
+  // not worth starting threads for
+  std::vector<size_t> chunk_first(chunks + 1, 0);
+  for (size_t k = 0; k < polygons; k++)
+    chunk_first[k / chunk_size + 1] += max_triangles(ring_starts[k + 1]
+        - ring_starts[k]);
+  for (size_t c = 0; c < chunks; c++)
+    chunk_first[c + 1] += chunk_first[c];
+
+  // every worker would write the winding of its polygons to the same place
+  triangulate_options shared = options;
+  shared.winding = nullptr;
+  run_chunks(chunks, workers, [&](size_t c) {
+        size_t end = std::min(polygons, (c + 1) * chunk_size)
+          , t = chunk_first[c];
+        for (size_t k = c * chunk_size; k < end; k++) {
+          uint32_t first = ring_starts[k], n = ring_starts[k + 1] - first;
+          size_t m = max_triangles(n);
+          uint32_t *tri = indices + 3 * t;
+          index_sink out(tri, nullptr, m);
+          triangulate_polygon(vertices + first, n, nullptr, 0, shared, &out);
+          for (size_t i = 0; i < 3 * out.count; i++)
+            tri[i] += first;
+          for (size_t i = 3 * out.count; i < 3 * m; i++)
+            tri[i] = first;
+          t += m;
+        }
+      });
+  return chunk_first[chunks];
+}
+
+#define INSTANTIATE(T) \
+  template size_t triangulate_batch(const vec2<T> *vertices \
+      , const uint32_t *ring_starts, size_t polygons \
+      , const triangulate_options &options, uint32_t *indices \
+      , unsigned threads);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
@@ -0,0 +1,212 @@
+#include "poly2tri.hh"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+// times every method on a few families of polygons, and then where Auto
+// should switch between them on this machine. make bench builds and runs it
+
+typedef std::vector<vec2<double>> outline;
+
+static outline circle(size_t n) {
+  outline v(n);
+  for (size_t i = 0; i < n; i++) {
+    double a = 2 * M_PI * i / n;
+    v[i] = { std::cos(a), std::sin(a) };
+  }
+  return v;
+}
+
+// every other vertex pulled halfway in
+static outline star(size_t n) {
+  outline v = circle(n);
+  for (size_t i = 1; i < n; i += 2)
+    v[i] = { v[i].x / 2, v[i].y / 2 };
+  return v;
+}
+
+// a circle whose radius wanders by up to a fifth
+static outline noisy(size_t n) {
+  std::mt19937 random(n);
+  std::uniform_real_distribution<double> radius(0.8, 1);
+  outline v = circle(n);
+  for (vec2<double> &p : v) {
+    double r = radius(random);
+    p = { r * p.x, r * p.y };
+  }
+  return v;
+}
+
+// teeth hanging down from a bar, four vertices a tooth
+static outline comb(size_t n) {
+  size_t teeth = std::max<size_t>(n / 4, 1);
+  outline v;
+  for (size_t t = 0; t < teeth; t++) {
+    double x = (double)t;
+    v.push_back({ x, 0 });
+    v.push_back({ x + 0.5, 0 });
+    v.push_back({ x + 0.5, 1 });
+    v.push_back({ x + 1, 1 });
+  }
+  v.push_back({ (double)teeth, 2 });
+  v.push_back({ 0, 2 });
+  return v;
+}
+
+// a circle stretched `aspect` times along x, convex with every vertex on
+// the boundary of the same ellipse
+static outline ellipse(size_t n, double aspect) {
+  outline v = circle(n);
+  for (vec2<double> &p : v)
+    p.x *= aspect;
+  return v;
+}
+
+// a bar with a sine wave of a hundred periods along its top, which leaves
+// long runs of reflex vertices between the ears
+static outline wave(size_t n) {
+  size_t top = std::max<size_t>(n, 4) - 2;
+  outline v;
+  v.push_back({ 0, 0 });
+  v.push_back({ 200 * M_PI, 0 });
+  for (size_t i = top; i-- > 0; ) {
+    double x = 200 * M_PI * i / (top - 1);
+    v.push_back({ x, 2 + std::sin(x) });
+  }
+  return v;
+}
+
+// nanoseconds a vertex, the best of three runs
+static double time_method(const outline &v, int method) {
+  std::vector<uint32_t> indices(3 * max_triangles(v.size()));
+  triangulate_options options(method);
+  size_t repeats = std::max<size_t>(4, (1 << 15) / v.size());
+  double best = HUGE_VAL;
+  for (int run = 0; run < 3; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeats; r++)
+      triangulate(v.data(), v.size(), options, indices.data());
+    std::chrono::duration<double, std::nano> took
+      = std::chrono::steady_clock::now() - start;
+    best = std::min(best, took.count() / repeats / v.size());
+  }
+  return best;
+}
+
+int main() {
+  struct family
+  {
+    const char *name;
+    outline (*make)(size_t n);
+  } families[] = { { "circle", circle }, { "star", star }, { "noisy", noisy }
+    , { "comb", comb } };
+  struct named_method
+  {
+    const char *name;
+    int method;
+  } methods[] = { { "monotone", MonotoneSweep }, { "earclip", EarClipping }
+    , { "cdt", ConstrainedDelaunay }, { "seidel", Trapezoidation }
+    , { "auto", Auto } };
+  printf("ns per vertex\n%-8s %6s", "", "n");
+  for (const named_method &m : methods)
+    printf(" %9s", m.name);
+  printf(" %9s\n", "auto took");
+  for (const family &f : families)
+    for (size_t n = 8; n <= 2048; n *= 4) {
+      outline v = f.make(n);
+      printf("%-8s %6zu", f.name, v.size());
+      double best = HUGE_VAL;
+      int fastest = 0;
+      for (const named_method &m : methods) {
+        double t = time_method(v, m.method);
+        if (m.method != Auto && t < best)
+          best = t, fastest = m.method;
+        printf(" %9.1f", t);
+      }
+      polygon_stats stats = measure_polygon(v.data(), v.size());
+      int chosen = choose_method(stats, dispatch_thresholds());
+      const char *name = chosen == StackBased ? "fan" : "";
+      for (const named_method &m : methods)
+        if (m.method == chosen)
+          name = m.name;
+      printf(" %9s%s\n", name, chosen == fastest || chosen == StackBased
+          ? "" : " *");
+    }
+  printf("* auto didn't take the fastest method\n\n");
+
+  // what makes a delaunay triangulation go quadratic is convex and
+  // cocircular input, so that's what it's scaled on. every 4 times the
+  // vertices should take not much more than 4 times as long
+  printf("ms, and how many times longer than at a quarter the vertices\n");
+  struct scaled
+  {
+    const char *name;
+    double aspect;
+    bool flips;
+  } cases[] = { { "cdt circle", 1, false }, { "cdt ellipse", 1000, false }
+    , { "flips ellipse", 1000, true } };
+  printf("%-14s", "n");
+  for (size_t n = 2048; n <= 131072; n *= 4)
+    printf(" %8zu      ", n);
+  printf("\n");
+  for (const scaled &c : cases) {
+    printf("%-14s", c.name);
+    double before = 0;
+    for (size_t n = 2048; n <= 131072; n *= 4) {
+      outline v = ellipse(n, c.aspect);
+      std::vector<uint32_t> indices(3 * max_triangles(n));
+      triangulate_options options(c.flips ? EarClipping : ConstrainedDelaunay);
+      options.delaunay_flips = c.flips;
+      auto start = std::chrono::steady_clock::now();
+      triangulate(v.data(), n, options, indices.data());
+      std::chrono::duration<double, std::milli> took
+        = std::chrono::steady_clock::now() - start;
+      if (before > 0)
+        printf(" %8.1f %4.1fx", took.count(), took.count() / before);
+      else
+        printf(" %8.1f      ", took.count());
+      before = took.count();
+    }
+    printf("\n");
+  }
+  printf("\n");
+
+  // with the z-order index the ear clipper should take about as long a
+  // vertex whatever the size. the noisy outline and the wave can't be cut
+  // up without long thin ears, which run across more cells of the index the
+  // more vertices there are around them, and grow about as the square root
+  printf("ns per vertex, ear clipper with the z-order index\n%-8s", "n");
+  for (size_t n = 4096; n <= 1 << 20; n *= 4)
+    printf(" %8zu", n);
+  printf("\n");
+  family large[] = { { "star", star }, { "noisy", noisy }, { "comb", comb }
+    , { "wave", wave } };
+  for (const family &f : large) {
+    printf("%-8s", f.name);
+    for (size_t n = 4096; n <= 1 << 20; n *= 4) {
+      outline v = f.make(n);
+      std::vector<uint32_t> indices(3 * max_triangles(v.size()));
+      triangulate_options options(EarClipping);
+      options.zorder_index = true;
+      auto start = std::chrono::steady_clock::now();
+      triangulate(v.data(), v.size(), options, indices.data());
+      std::chrono::duration<double, std::nano> took
+        = std::chrono::steady_clock::now() - start;
+      printf(" %8.0f", took.count() / v.size());
+      fflush(stdout);
+    }
+    printf("\n");
+  }
+  printf("\n");
+
+  printf("calibrating...\n");
+  dispatch_thresholds defaults, measured = calibrate_dispatch();
+  printf("%-18s %9s %9s\n", "", "default", "measured");
+  printf("%-18s %9zu %9zu\n", "earclip_vertices", defaults.earclip_vertices
+      , measured.earclip_vertices);
+  printf("%-18s %9zu %9zu\n", "earclip_reflex", defaults.earclip_reflex
+      , measured.earclip_reflex);
+  printf("%-18s %9g %9g\n", "earclip_aspect", defaults.earclip_aspect
+      , measured.earclip_aspect);
+}
@@ -0,0 +1,197 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <cmath>
+
+// tom forsyth's "linear-speed vertex cache optimisation". every vertex is
+// scored by where it sits in a simulated lru cache and by how many triangles
+// it still has to go into, and the triangle with the highest total goes
+// next. only the triangles around the vertices in the cache ever change
+// score, so those are the only ones looked at, and when none of them is left
+// the next triangle not drawn yet in input order starts over. a triangle's
+// score is the sum of its vertices', added up whenever it's looked at
+
+static const size_t lru_size = 32, valence_scores = 32;
+static const uint32_t candidates = 8;
+
+struct score_tables
+{
+  float cache[lru_size + 1], valence[valence_scores];
+
+  score_tables() {
+    // the last triangle's vertices get the same fixed score, so that it
+    // doesn't matter which way round the next one goes
+    for (size_t p = 0; p < lru_size; p++)
+      cache[p] = p < 3 ? 0.75f
+        : std::pow(1 - (float)(p - 3) / (lru_size - 3), 1.5f);
+    cache[lru_size] = 0;
+    valence[0] = 0;
+    for (size_t v = 1; v < valence_scores; v++)
+      valence[v] = 2 / std::sqrt((float)v);
+  }
+};
+
+// `position` is lru_size for a vertex that isn't in the cache
+static float vertex_score(size_t position, size_t valence) {
+  static const score_tables tables;
+  if (valence == 0)
+    return -1;
+  return tables.cache[position]
+    + tables.valence[std::min(valence, valence_scores - 1)];
+}
+
+void reorder_triangles(uint32_t *indices, int32_t *neighbors
+    , size_t triangles, const std::vector<uint32_t> &order) {
+  std::vector<uint32_t> sorted(3 * triangles);
+  for (size_t i = 0; i < triangles; i++)
+    std::copy(indices + 3 * order[i], indices + 3 * order[i] + 3
+        , &sorted[3 * i]);
+  std::copy(sorted.begin(), sorted.end(), indices);
+  if (!neighbors)
+    return;
+  std::vector<int32_t> renamed(triangles), moved(3 * triangles);
+  for (size_t i = 0; i < triangles; i++)
+    renamed[order[i]] = i;
+  for (size_t i = 0; i < triangles; i++)
+    for (int k = 0; k < 3; k++) {
+      int32_t u = neighbors[3 * order[i] + k];
+      moved[3 * i + k] = u == -1 ? -1 : renamed[u];
+    }
+  std::copy(moved.begin(), moved.end(), neighbors);
+}
+
+double acmr(const uint32_t *indices, size_t triangles, size_t n
+    , size_t cache_size) {
+  if (triangles == 0)
+    return 0;
+  // a fifo, as the hardware has it: vertex v is in the cache as long as
+  // fewer than cache_size misses have come after its own
+  std::vector<size_t> stamp(n, 0);
+  size_t misses = 0;
+  for (size_t i = 0; i < 3 * triangles; i++) {
+    uint32_t v = indices[i];
+    if (stamp[v] == 0 || misses - stamp[v] >= cache_size)
+      stamp[v] = ++misses;
+  }
+  return (double)misses / triangles;
+}
+
+cache_stats optimize_vertex_cache(uint32_t *indices, int32_t *neighbors
+    , size_t triangles, size_t n, size_t cache_size) {
+  cache_stats stats;
+  stats.acmr_before = acmr(indices, triangles, n, cache_size);
+
+  // the corners at every vertex, and how many of them are left. a triangle
+  // with a vertex at more than one corner, as the padding of
+  // triangulate_batch() has, is around it that many times
+  std::vector<uint32_t> first(n + 1, 0), around(3 * triangles);
+  for (size_t i = 0; i < 3 * triangles; i++)
+    first[indices[i] + 1]++;
+  for (size_t v = 0; v < n; v++)
+    first[v + 1] += first[v];
+  // where every corner is in the list around its vertex, so that it can be
+  // taken out of there straight away
+  std::vector<uint32_t> valence(n), fill(first.begin(), first.end() - 1)
+    , slot(3 * triangles);
+  for (size_t i = 0; i < 3 * triangles; i++) {
+    slot[i] = fill[indices[i]]++;
+    around[slot[i]] = i;
+  }
+  for (size_t v = 0; v < n; v++)
+    valence[v] = first[v + 1] - first[v];
+
+  std::vector<float> score(n);
+  for (size_t v = 0; v < n; v++)
+    score[v] = vertex_score(lru_size, valence[v]);
+
+  std::vector<uint8_t> drawn(triangles, 0);
+  std::vector<uint32_t> order, cache, next_cache;
+  order.reserve(triangles);
+  size_t cursor = 0;
+  int32_t best = triangles ? 0 : -1;
+  while (best != -1) {
+    order.push_back(best);
+    drawn[best] = 1;
+    const uint32_t *c = indices + 3 * best;
+    // the triangle's vertices move to the front, the rest down behind them
+    next_cache.assign(c, c + 3);
+    for (uint32_t v : cache)
+      if (v != c[0] && v != c[1] && v != c[2])
+        next_cache.push_back(v);
+    // the corners of drawn triangles are swapped out past the ones left
+    // around a vertex
+    for (int k = 0; k < 3; k++) {
+      uint32_t v = c[k], last = first[v] + --valence[v], other = around[last]
+        , here = slot[3 * best + k];
+      std::swap(around[here], around[last]);
+      slot[other] = here;
+      slot[3 * best + k] = last;
+    }
+    // vertices pushed out of the cache are rescored along with the ones
+    // still in it, and the next triangle is the best one around any of them.
+    // only the first few around every vertex are looked at, or the center of
+    // a fan would have all of its triangles looked at again for every one
+    // drawn
+    for (size_t p = 0; p < next_cache.size(); p++) {
+      uint32_t v = next_cache[p];
+      score[v] = vertex_score(std::min(p, lru_size), valence[v]);
+    }
+    best = -1;
+    float best_score = -1;
+    for (uint32_t v : next_cache)
+      for (uint32_t j = first[v], end = j + std::min(valence[v], candidates);
+          j < end; j++) {
+        uint32_t t = around[j] / 3;
+        if (drawn[t])
+          continue;
+        const uint32_t *d = indices + 3 * t;
+        float total = score[d[0]] + score[d[1]] + score[d[2]];
+        if (total > best_score) {
+          best_score = total;
+          best = t;
+        }
+      }
+    if (next_cache.size() > lru_size)
+      next_cache.resize(lru_size);
+    cache.swap(next_cache);
+    if (best == -1) {
+      while (cursor < triangles && drawn[cursor])
+        cursor++;
+      best = cursor < triangles ? cursor : -1;
+    }
+  }
+
+  reorder_triangles(indices, neighbors, triangles, order);
+  stats.acmr_after = acmr(indices, triangles, n, cache_size);
+  return stats;
+}
+
+template <typename T>
+void optimize_vertex_fetch(vec2<T> *vertices, size_t n, uint32_t *indices
+    , size_t triangles, uint32_t *remap) {
+  std::vector<uint32_t> renamed(n, UINT32_MAX);
+  uint32_t next = 0;
+  for (size_t i = 0; i < 3 * triangles; i++) {
+    uint32_t &v = renamed[indices[i]];
+    if (v == UINT32_MAX)
+      v = next++;
+    indices[i] = v;
+  }
+  // the ones no triangle uses go at the end, in the order they were in
+  for (size_t v = 0; v < n; v++)
+    if (renamed[v] == UINT32_MAX)
+      renamed[v] = next++;
+  std::vector<vec2<T>> moved(n);
+  for (size_t v = 0; v < n; v++)
+    moved[renamed[v]] = vertices[v];
+  std::copy(moved.begin(), moved.end(), vertices);
+  if (remap)
+    std::copy(renamed.begin(), renamed.end(), remap);
+}
+
+#define INSTANTIATE(T) \
+  template void optimize_vertex_fetch(vec2<T> *vertices, size_t n \
+      , uint32_t *indices, size_t triangles, uint32_t *remap);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
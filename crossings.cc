@@ -0,0 +1,461 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <set>
+
+// bentley-ottmann. a line sweeps down the plane, meeting the vertices in the
+// order above() gives them, and the edges it crosses are kept in a balanced
+// tree from left to right. only edges next to each other in the tree can
+// meet next, so every time two of them come to be neighbours, and cross
+// further down, the point where they do is queued as an event of its own,
+// where the two change places. at a vertex every edge that ends there, starts
+// there or runs through it comes out of the tree, and the ones going on below
+// it go back in in their new order, as in de berg et al. whether and on which
+// side edges pass a vertex is settled with the exact predicates, so up to the
+// first crossing the sweep is exact and is_simple() can't be wrong. the
+// points where edges cross are rounded, so past them the order of events
+// that close to one another may come out wrong
+
+static const uint32_t probe = UINT32_MAX;
+
+template <typename T>
+struct crossing_sweep;
+
+// the order of the edges along the sweep line. besides edges the tree holds,
+// it only ever has to place edges that pass the current point and the point
+// itself, `probe`
+template <typename T>
+struct status_order
+{
+  const crossing_sweep<T> *sweep;
+
+  bool operator()(uint32_t a, uint32_t b) const;
+};
+
+struct crossing_event
+{
+  vec2<double> point;
+  uint32_t left, right;
+};
+
+struct later_event
+{
+  bool operator()(const crossing_event &a, const crossing_event &b) const {
+    return above(b.point, a.point);
+  }
+};
+
+template <typename T>
+struct crossing_sweep
+{
+  const vec2<T> *vertices;
+  size_t n;
+  // edge i runs from vertex i to next[i], and `upper` and `lower` are its
+  // ends in the order the sweep meets them. `after` is the edge after it on
+  // its ring, edges of no length left out
+  std::vector<uint32_t> next, prev, upper, lower, after;
+  vec2<T> point;
+  vec2<double> at;
+  std::set<uint32_t, status_order<T>> status;
+  std::vector<typename std::set<uint32_t, status_order<T>>::iterator> where;
+  std::vector<uint8_t> in_status;
+  std::priority_queue<crossing_event, std::vector<crossing_event>
+    , later_event> events;
+  std::vector<edge_crossing> *crossings;
+  bool first_only;
+
+  crossing_sweep(const vec2<T> *n_vertices, size_t n_n
+      , const uint32_t *hole_starts, size_t holes);
+  bool empty(uint32_t e) const {
+    const vec2<T> &a = vertices[e], &b = vertices[next[e]];
+    return a.x == b.x && a.y == b.y;
+  }
+  // positive when the current point lies right of edge e, 0 when on it
+  typename wide_type<T>::type side(uint32_t e) const {
+    return orient(vertices[upper[e]], vertices[lower[e]], point);
+  }
+  bool report(uint32_t a, uint32_t b, vec2<double> p);
+  void check(typename std::set<uint32_t, status_order<T>>::iterator left
+      , typename std::set<uint32_t, status_order<T>>::iterator right);
+  bool cross(const crossing_event &c);
+  bool pass(uint32_t v, const std::vector<uint32_t> &order, size_t end);
+  void run();
+};
+
+template <typename T>
+bool status_order<T>::operator()(uint32_t a, uint32_t b) const {
+  if (a == b)
+    return false;
+  if (b == probe)
+    return sweep->side(a) > 0;
+  if (a == probe)
+    return sweep->side(b) < 0;
+  auto sa = sweep->side(a), sb = sweep->side(b);
+  if (sa != 0)
+    return sa > 0;
+  if (sb != 0)
+    return sb < 0;
+  // both pass the point, and the one whose way down turns left goes first
+  auto o = orient(sweep->point, sweep->vertices[sweep->lower[a]]
+      , sweep->vertices[sweep->lower[b]]);
+  if (o != 0)
+    return o > 0;
+  return a < b;
+}
+
+template <typename T>
+crossing_sweep<T>::crossing_sweep(const vec2<T> *n_vertices, size_t n_n
+    , const uint32_t *hole_starts, size_t holes)
+  : vertices(n_vertices), n(n_n), upper(n), lower(n)
+  , after(n, probe), status(status_order<T> { this }), where(n)
+  , in_status(n, 0), crossings(nullptr), first_only(false) {
+  polygon_rings rings(n, hole_starts, holes);
+  next.swap(rings.next);
+  prev.swap(rings.prev);
+  for (uint32_t e = 0; e < n; e++) {
+    bool down = above(vertices[e], vertices[next[e]]);
+    upper[e] = down ? e : next[e];
+    lower[e] = down ? next[e] : e;
+  }
+  for (uint32_t e = 0; e < n; e++) {
+    if (empty(e))
+      continue;
+    uint32_t f = next[e];
+    while (f != e && empty(f))
+      f = next[f];
+    after[e] = f;
+  }
+}
+
+// adds the contact between edges a and b at p, unless they're neighbours on
+// their ring that only meet where one follows the other. returns whether to
+// stop
+template <typename T>
+bool crossing_sweep<T>::report(uint32_t a, uint32_t b, vec2<double> p) {
+  uint32_t shared = after[a] == b ? b : after[b] == a ? a : probe;
+  // two edges that make up a ring on their own meet at both ends, and are
+  // reported at the first one
+  if (after[a] == b && after[b] == a)
+    shared = lower[a];
+  if (shared != probe && (double)vertices[shared].x == p.x
+      && (double)vertices[shared].y == p.y)
+    return false;
+  crossings->push_back({ std::min(a, b), std::max(a, b), p });
+  return first_only;
+}
+
+// queues the point where two neighbours on the sweep line cross below it.
+// ones that only touch meet at a vertex, and are found there
+template <typename T>
+void crossing_sweep<T>::check(
+    typename std::set<uint32_t, status_order<T>>::iterator left
+    , typename std::set<uint32_t, status_order<T>>::iterator right) {
+  if (right == status.end())
+    return;
+  uint32_t s = *left, t = *right;
+  const vec2<T> &a = vertices[upper[s]], &b = vertices[lower[s]]
+    , &c = vertices[upper[t]], &d = vertices[lower[t]];
+  auto o1 = orient(a, b, c), o2 = orient(a, b, d);
+  if (!((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)))
+    return;
+  // and the left one has to end up right of the other, or they've crossed
+  // already
+  auto o3 = orient(c, d, a), o4 = orient(c, d, b);
+  if (!(o3 < 0 && o4 > 0))
+    return;
+  double ax = (double)a.x, ay = (double)a.y, bx = (double)b.x
+    , by = (double)b.y, cx = (double)c.x, cy = (double)c.y
+    , dx = (double)d.x - cx, dy = (double)d.y - cy
+    , da = dx * (ay - cy) - dy * (ax - cx), db = dx * (by - cy) - dy * (bx - cx)
+    , f = da / (da - db);
+  vec2<double> x = { ax + f * (bx - ax), ay + f * (by - ay) };
+  // rounding may have taken it past the ends of either edge, or above the
+  // point the sweep is at
+  x.x = std::max(x.x, std::max(std::min(ax, bx), std::min(cx, cx + dx)));
+  x.x = std::min(x.x, std::min(std::max(ax, bx), std::max(cx, cx + dx)));
+  x.y = std::max(x.y, std::max(std::min(ay, by), std::min(cy, cy + dy)));
+  x.y = std::min(x.y, std::min(std::max(ay, by), std::max(cy, cy + dy)));
+  if (!above(at, x))
+    x = at;
+  events.push({ x, s, t });
+}
+
+// two edges that are still neighbours in the tree change places
+template <typename T>
+bool crossing_sweep<T>::cross(const crossing_event &c) {
+  if (!in_status[c.left] || !in_status[c.right])
+    return false;
+  auto left = where[c.left], right = std::next(left);
+  if (right == status.end() || *right != c.right)
+    return false;
+  at = c.point;
+  if (report(c.left, c.right, c.point))
+    return true;
+  const_cast<uint32_t &>(*left) = c.right;
+  const_cast<uint32_t &>(*right) = c.left;
+  where[c.right] = left;
+  where[c.left] = right;
+  if (left != status.begin())
+    check(std::prev(left), left);
+  check(right, std::next(right));
+  return false;
+}
+
+// passes the vertices order[v] up to order[end], which all lie at the same
+// point
+template <typename T>
+bool crossing_sweep<T>::pass(uint32_t v, const std::vector<uint32_t> &order
+    , size_t end) {
+  point = vertices[order[v]];
+  at = { (double)point.x, (double)point.y };
+  // the edges that start here, and the ones the tree has passing through
+  std::vector<uint32_t> starting, passing;
+  for (size_t i = v; i < end; i++) {
+    uint32_t w = order[i];
+    for (uint32_t e : { w, prev[w] })
+      if (!empty(e) && upper[e] == w)
+        starting.push_back(e);
+  }
+  for (auto it = status.lower_bound(probe); it != status.end()
+      && side(*it) == 0; ++it)
+    passing.push_back(*it);
+  std::vector<uint32_t> all(starting);
+  all.insert(all.end(), passing.begin(), passing.end());
+  for (size_t i = 0; i < all.size(); i++)
+    for (size_t j = i + 1; j < all.size(); j++)
+      if (report(all[i], all[j], at))
+        return true;
+
+  for (uint32_t e : passing) {
+    status.erase(where[e]);
+    in_status[e] = 0;
+  }
+  // the ones that don't end here go back in below it
+  for (uint32_t e : passing)
+    if (!(vertices[lower[e]].x == point.x && vertices[lower[e]].y == point.y))
+      starting.push_back(e);
+  for (uint32_t e : starting) {
+    where[e] = status.insert(e).first;
+    in_status[e] = 1;
+  }
+  auto first = status.lower_bound(probe), last = status.upper_bound(probe);
+  if (first != status.begin())
+    check(std::prev(first), first);
+  if (last != status.begin() && last != first)
+    check(std::prev(last), last);
+  return false;
+}
+
+template <typename T>
+void crossing_sweep<T>::run() {
+  std::vector<uint32_t> order;
+  for (uint32_t v = 0; v < n; v++)
+    if (!empty(v) || !empty(prev[v]))
+      order.push_back(v);
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return above(vertices[a], vertices[b]);
+      });
+  size_t v = 0;
+  while (v < order.size() || !events.empty()) {
+    const vec2<T> &p = vertices[order[std::min(v, order.size() - 1)]];
+    vec2<double> dp = { (double)p.x, (double)p.y };
+    if (!events.empty() && (v == order.size() || above(events.top().point
+            , dp))) {
+      crossing_event c = events.top();
+      events.pop();
+      if (cross(c))
+        return;
+      continue;
+    }
+    size_t end = v + 1;
+    while (end < order.size() && vertices[order[end]].x == p.x
+        && vertices[order[end]].y == p.y)
+      end++;
+    if (pass(v, order, end))
+      return;
+    v = end;
+  }
+}
+
+template <typename T>
+size_t find_crossings(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , std::vector<edge_crossing> *crossings, bool first_only) {
+  crossings->clear();
+  if (n < 3)
+    return 0;
+  crossing_sweep<T> sweep(vertices, n, hole_starts, holes);
+  sweep.crossings = crossings;
+  sweep.first_only = first_only;
+  sweep.run();
+  return crossings->size();
+}
+
+template <typename T>
+bool is_simple(const vec2<T> *vertices, size_t n, const uint32_t *hole_starts
+    , size_t holes) {
+  std::vector<edge_crossing> crossings;
+  return find_crossings(vertices, n, hole_starts, holes, &crossings, true)
+    == 0;
+}
+
+template <typename T>
+static T round_to(double x) {
+  return (T)x;
+}
+
+template <>
+int32_t round_to(double x) {
+  return (int32_t)std::lround(x);
+}
+
+// every crossing point is put into both edges, and then the ring is cut into
+// loops at every point it comes back to: going around it, a point met a
+// second time closes the loop from its first visit on, which is taken out
+template <typename T>
+size_t split_simple(const vec2<T> *vertices, size_t n
+    , std::vector<vec2<T>> *pieces, std::vector<uint32_t> *ring_starts) {
+  pieces->clear();
+  ring_starts->assign(1, 0);
+  std::vector<edge_crossing> crossings;
+  find_crossings(vertices, n, nullptr, 0, &crossings, false);
+  if (n < 3)
+    return 0;
+
+  // where more than two edges cross at one point, every pair of them works
+  // it out on its own and they come out a rounding error apart. every
+  // crossing point is taken to be the first vertex, or failing that the
+  // first other crossing point, that close to it, so the ring gets back to
+  // the same point and no edge of no length is left between them
+  std::vector<vec2<T>> points(vertices, vertices + n);
+  for (const edge_crossing &c : crossings)
+    points.push_back({ round_to<T>(c.point.x), round_to<T>(c.point.y) });
+  double extent = 0;
+  for (size_t i = 0; i < n; i++)
+    extent = std::max(extent, std::max(std::fabs((double)vertices[i].x)
+          , std::fabs((double)vertices[i].y)));
+  double close = 16 * (double)std::numeric_limits<T>::epsilon() * extent;
+  std::vector<uint32_t> by_x(points.size()), same(points.size());
+  for (uint32_t i = 0; i < points.size(); i++)
+    by_x[i] = same[i] = i;
+  std::sort(by_x.begin(), by_x.end(), [&](uint32_t a, uint32_t b) {
+        return points[a].x < points[b].x;
+      });
+  for (size_t i = 0; i < by_x.size(); i++) {
+    uint32_t a = by_x[i];
+    if (a < n)
+      continue;
+    auto near = [&](size_t j) {
+      const vec2<T> &b = points[by_x[j]];
+      return std::fabs((double)points[a].x - (double)b.x) <= close;
+    };
+    auto join = [&](size_t j) {
+      if (std::fabs((double)points[a].y - (double)points[by_x[j]].y) <= close)
+        same[a] = std::min(same[a], same[by_x[j]]);
+    };
+    for (size_t j = i; j-- > 0 && near(j); )
+      join(j);
+    for (size_t j = i + 1; j < by_x.size() && near(j); j++)
+      join(j);
+  }
+
+  // the points to go into every edge, by their distance from its start
+  std::vector<std::vector<std::pair<double, vec2<T>>>> inside(n);
+  for (size_t i = 0; i < crossings.size(); i++) {
+    const edge_crossing &c = crossings[i];
+    vec2<T> p = points[same[n + i]];
+    for (uint32_t e : { c.first, c.second }) {
+      const vec2<T> &a = vertices[e], &b = vertices[(e + 1) % n];
+      if ((p.x == a.x && p.y == a.y) || (p.x == b.x && p.y == b.y))
+        continue;
+      double dx = (double)p.x - (double)a.x, dy = (double)p.y - (double)a.y;
+      inside[e].push_back({ dx * dx + dy * dy, p });
+    }
+  }
+  // a point an edge crosses two others at goes into it once
+  std::vector<vec2<T>> ring;
+  auto visit = [&](const vec2<T> &p) {
+    if (ring.empty() || ring.back().x != p.x || ring.back().y != p.y)
+      ring.push_back(p);
+  };
+  for (size_t e = 0; e < n; e++) {
+    visit(vertices[e]);
+    std::sort(inside[e].begin(), inside[e].end()
+        , [](const std::pair<double, vec2<T>> &a
+          , const std::pair<double, vec2<T>> &b) {
+          return a.first < b.first;
+        });
+    for (const std::pair<double, vec2<T>> &p : inside[e])
+      visit(p.second);
+  }
+  if (ring.size() > 1 && ring.back().x == ring[0].x
+      && ring.back().y == ring[0].y)
+    ring.pop_back();
+
+  // every point gets the number of the first one at the same place
+  size_t m = ring.size();
+  std::vector<uint32_t> by_place(m), place(m);
+  for (uint32_t i = 0; i < m; i++)
+    by_place[i] = i;
+  std::sort(by_place.begin(), by_place.end(), [&](uint32_t a, uint32_t b) {
+        return ring[a].x < ring[b].x
+          || (ring[a].x == ring[b].x && ring[a].y < ring[b].y);
+      });
+  for (size_t i = 0; i < m; i++) {
+    uint32_t a = by_place[i], b = by_place[i == 0 ? 0 : i - 1];
+    place[a] = i > 0 && ring[a].x == ring[b].x && ring[a].y == ring[b].y
+      ? place[b] : a;
+  }
+
+  // pieces that wind cw are turned around, those of no area dropped
+  auto add = [&](const vec2<T> *piece, size_t size) {
+    if (size < 3)
+      return;
+    double area = signed_area(piece, size);
+    if (area == 0)
+      return;
+    if (area > 0)
+      pieces->insert(pieces->end(), piece, piece + size);
+    else
+      pieces->insert(pieces->end(), std::reverse_iterator<const vec2<T> *>(
+            piece + size), std::reverse_iterator<const vec2<T> *>(piece));
+    ring_starts->push_back(pieces->size());
+  };
+  std::vector<uint32_t> stack, on_stack(m, probe);
+  std::vector<vec2<T>> piece;
+  for (uint32_t i = 0; i < m; i++) {
+    uint32_t k = on_stack[place[i]];
+    if (k == probe) {
+      on_stack[place[i]] = stack.size();
+      stack.push_back(i);
+      continue;
+    }
+    piece.clear();
+    for (size_t j = k; j < stack.size(); j++) {
+      piece.push_back(ring[stack[j]]);
+      if (j > k)
+        on_stack[place[stack[j]]] = probe;
+    }
+    add(piece.data(), piece.size());
+    stack.resize(k + 1);
+  }
+  piece.clear();
+  for (uint32_t i : stack)
+    piece.push_back(ring[i]);
+  add(piece.data(), piece.size());
+  return ring_starts->size() - 1;
+}
+
+#define INSTANTIATE(T) \
+  template size_t find_crossings(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes \
+      , std::vector<edge_crossing> *crossings, bool first_only); \
+  template bool is_simple(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes); \
+  template size_t split_simple(const vec2<T> *vertices, size_t n \
+      , std::vector<vec2<T>> *pieces, std::vector<uint32_t> *ring_starts);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
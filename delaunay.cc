@@ -0,0 +1,575 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <deque>
+#include <random>
+
+// pairs up the two halves of every inner edge. half-edges are bucketed by
+// their lower vertex with a counting sort, so only edges around the same
+// vertex are ever compared
+void build_neighbors(const uint32_t *corners, size_t triangles, size_t n
+    , int32_t *neighbors) {
+  size_t hn = 3 * triangles;
+  auto next = [](size_t h) {
+    return h % 3 == 2 ? h - 2 : h + 1;
+  };
+  std::vector<uint32_t> first(n + 1, 0), bucket(hn);
+  for (size_t h = 0; h < hn; h++) {
+    first[std::min(corners[h], corners[next(h)]) + 1]++;
+    neighbors[h] = -1;
+  }
+  for (size_t i = 0; i < n; i++)
+    first[i + 1] += first[i];
+  std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+  for (size_t h = 0; h < hn; h++)
+    bucket[fill[std::min(corners[h], corners[next(h)])]++] = h;
+
+  auto other = [&](uint32_t h) {
+    return std::max(corners[h], corners[next(h)]);
+  };
+  for (size_t i = 0; i < n; i++) {
+    uint32_t *b = bucket.data() + first[i], size = first[i + 1] - first[i];
+    if (size > 8)
+      std::sort(b, b + size, [&](uint32_t x, uint32_t y) {
+            return other(x) < other(y);
+          });
+    for (uint32_t j = 0; j < size; j++) {
+      if (neighbors[b[j]] != -1)
+        continue;
+      for (uint32_t k = j + 1; k < size; k++) {
+        if (size > 8 && other(b[k]) != other(b[j]))
+          break;
+        if (corners[b[k]] == corners[next(b[j])]
+            && corners[next(b[k])] == corners[b[j]]
+            && neighbors[b[k]] == -1) {
+          neighbors[b[j]] = b[k] / 3;
+          neighbors[b[k]] = b[j] / 3;
+          break;
+        }
+      }
+    }
+  }
+}
+
+// fills in the neighbours of the triangles already written to `out`
+void link_output(size_t n, index_sink *out) {
+  std::vector<uint32_t> corners(3 * out->count);
+  for (size_t i = 0; i < corners.size(); i++)
+    corners[i] = out->corner(i);
+  build_neighbors(corners.data(), out->count, n, out->neighbors);
+}
+
+// points whichever edge of triangle `t` faced `from` at `to` instead
+static void relink(int32_t *nb, int32_t t, int32_t from, int32_t to) {
+  if (t == -1)
+    return;
+  for (size_t k = 0; k < 3; k++)
+    if (nb[3 * t + k] == from) {
+      nb[3 * t + k] = to;
+      return;
+    }
+}
+
+// the edge of triangle u that runs from b to a, or 3 if there's none
+static uint32_t edge_from(const uint32_t *c, int32_t u, uint32_t b
+    , uint32_t a) {
+  uint32_t j = 0;
+  while (j < 3 && !(c[3 * u + j] == b && c[3 * u + (j + 1) % 3] == a))
+    j++;
+  return j;
+}
+
+// turns the edge between triangles t and u, edge k of t and edge j of u,
+// the other way around: abc + bad becomes cad + dbc, with the new edge last
+// in t and first in u
+static void flip(uint32_t *c, int32_t *nb, uint32_t t, uint32_t k, int32_t u
+    , uint32_t j) {
+  uint32_t a = c[3 * t + k], b = c[3 * t + (k + 1) % 3]
+    , cc = c[3 * t + (k + 2) % 3], d = c[3 * u + (j + 2) % 3];
+  int32_t n_bc = nb[3 * t + (k + 1) % 3], n_ca = nb[3 * t + (k + 2) % 3]
+    , n_ad = nb[3 * u + (j + 1) % 3], n_db = nb[3 * u + (j + 2) % 3];
+  c[3 * t] = cc, c[3 * t + 1] = a, c[3 * t + 2] = d;
+  nb[3 * t] = n_ca, nb[3 * t + 1] = n_ad, nb[3 * t + 2] = u;
+  c[3 * u] = d, c[3 * u + 1] = b, c[3 * u + 2] = cc;
+  nb[3 * u] = n_db, nb[3 * u + 1] = n_bc, nb[3 * u + 2] = t;
+  relink(nb, n_ad, u, t);
+  relink(nb, n_bc, t, u);
+}
+
+// lawson's algorithm: flips every inner edge that isn't locally delaunay
+// until none are left, working off a stack of edges to check. boundary edges
+// are never flipped, so the boundary of the triangulation acts as the
+// constraint. the number of flips is the distance from the delaunay
+// triangulation, which can be quadratic, so it's only ever started from
+// something close to it
+template <typename T>
+void legalize(const vec2<T> *vertices, mesh *m) {
+  uint32_t *c = m->corners.data();
+  int32_t *nb = m->neighbors.data();
+  size_t triangles = m->corners.size() / 3;
+  std::vector<uint32_t> stack;
+  stack.reserve(triangles * 3);
+  for (size_t t = 0; t < triangles; t++)
+    for (size_t k = 0; k < 3; k++)
+      if (nb[3 * t + k] > (int32_t)t)
+        stack.push_back(3 * t + k);
+
+  while (!stack.empty()) {
+    uint32_t h = stack.back(), t = h / 3, k = h % 3;
+    stack.pop_back();
+    int32_t u = nb[h];
+    if (u == -1)
+      continue;
+    uint32_t a = c[h], b = c[3 * t + (k + 1) % 3], cc = c[3 * t + (k + 2) % 3]
+      , j = edge_from(c, u, b, a);
+    if (j == 3)
+      continue;
+    uint32_t d = c[3 * u + (j + 2) % 3];
+    const vec2<T> &va = vertices[a], &vb = vertices[b], &vc = vertices[cc]
+      , &vd = vertices[d];
+    if (incircle(va, vb, vc, vd) <= 0 || orient(vc, va, vd) <= 0
+        || orient(vd, vb, vc) <= 0)
+      continue;
+    flip(c, nb, t, k, u, j);
+    stack.push_back(3 * t);
+    stack.push_back(3 * t + 1);
+    stack.push_back(3 * u);
+    stack.push_back(3 * u + 1);
+  }
+}
+
+// the delaunay triangulation of the vertices, grown a vertex at a time
+// inside a triangle big enough to hold them all, and then made to take the
+// edges of the polygon as constraints. it's kept in double, which holds
+// every type of coordinates exactly, so the predicates decide the same as
+// they would on the input. the vertices go in a randomized round at a time,
+// every round along a hilbert curve, which keeps both the walks to them and
+// the flips after them short, for o(n log n) expected time in all. the
+// polygon edges are mostly delaunay already, and the few that aren't are
+// flipped in one crossing edge at a time, as sloan does it
+struct delaunay_builder
+{
+  // the vertices and the three of the enclosing triangle after them
+  std::vector<vec2<double>> points;
+  size_t n;
+  std::vector<uint32_t> corners;
+  std::vector<int32_t> neighbors;
+  // a triangle every vertex is a corner of
+  std::vector<uint32_t> around;
+  // the polygon, whose edges are the constraints
+  const polygon_rings &rings;
+  std::vector<uint32_t> stack;
+  // which edge walks try first, turned every step so that they can't go
+  // round in circles
+  uint32_t turn;
+
+  delaunay_builder(const polygon_rings &n_rings)
+    : points(n_rings.n + 3), n(n_rings.n), around(n_rings.n + 3)
+    , rings(n_rings), turn(0) {}
+
+  double orient_at(uint32_t a, uint32_t b, uint32_t c) const {
+    return orient(points[a], points[b], points[c]);
+  }
+  void set(uint32_t t, uint32_t a, uint32_t b, uint32_t c, int32_t n0
+      , int32_t n1, int32_t n2) {
+    uint32_t *tc = &corners[3 * t];
+    int32_t *tn = &neighbors[3 * t];
+    tc[0] = a, tc[1] = b, tc[2] = c;
+    tn[0] = n0, tn[1] = n1, tn[2] = n2;
+    around[a] = around[b] = around[c] = t;
+  }
+  uint32_t add() {
+    corners.resize(corners.size() + 3);
+    neighbors.resize(neighbors.size() + 3);
+    return corners.size() / 3 - 1;
+  }
+  void flip_edge(uint32_t t, uint32_t k, int32_t u, uint32_t j) {
+    flip(corners.data(), neighbors.data(), t, k, u, j);
+    for (uint32_t i = 0; i < 3; i++) {
+      around[corners[3 * t + i]] = t;
+      around[corners[3 * u + i]] = u;
+    }
+  }
+  bool constraint(uint32_t a, uint32_t b) const {
+    return a < n && b < n && (rings.next[a] == b || rings.next[b] == a);
+  }
+  uint32_t corner_of(uint32_t t, uint32_t v) const {
+    uint32_t i = 0;
+    while (i < 3 && corners[3 * t + i] != v)
+      i++;
+    return i;
+  }
+
+  bool insert(uint32_t v, uint32_t *last);
+  bool find_edge(uint32_t x, uint32_t y, uint32_t *t, uint32_t *k) const;
+  bool constrain(uint32_t a, uint32_t b);
+  bool build(mesh *m);
+};
+
+// adds vertex v, walking to it from triangle `last`, and flips the edges
+// around it until it's delaunay again. fails on a vertex that's already in
+bool delaunay_builder::insert(uint32_t v, uint32_t *last) {
+  const vec2<double> &q = points[v];
+  uint32_t t = *last;
+  for (size_t steps = 0;; steps++) {
+    if (steps > corners.size())
+      return false;
+    uint32_t k = 0, e = 0;
+    for (; k < 3; k++) {
+      e = (k + turn) % 3;
+      if (orient(points[corners[3 * t + e]]
+            , points[corners[3 * t + (e + 1) % 3]], q) < 0)
+        break;
+    }
+    turn++;
+    if (k == 3)
+      break;
+    if (neighbors[3 * t + e] == -1)
+      return false;
+    t = neighbors[3 * t + e];
+  }
+  int on = -1;
+  for (int e = 0; e < 3; e++)
+    if (orient(points[corners[3 * t + e]]
+          , points[corners[3 * t + (e + 1) % 3]], q) == 0) {
+      if (on != -1)
+        return false;
+      on = e;
+    }
+
+  // the triangle, or the two on either side of the edge v is on, give way to
+  // a fan of triangles around v, one for every edge around them
+  uint32_t ring[4], slots[4], count;
+  int32_t outer[4];
+  if (on == -1) {
+    count = 3;
+    for (uint32_t i = 0; i < 3; i++) {
+      ring[i] = corners[3 * t + i];
+      outer[i] = neighbors[3 * t + i];
+    }
+    slots[0] = t, slots[1] = add(), slots[2] = add();
+  } else {
+    count = 4;
+    uint32_t k = on, a = corners[3 * t + k], b = corners[3 * t + (k + 1) % 3];
+    int32_t u = neighbors[3 * t + k];
+    if (u == -1)
+      return false;
+    uint32_t j = edge_from(corners.data(), u, b, a);
+    ring[0] = b, ring[1] = corners[3 * t + (k + 2) % 3], ring[2] = a;
+    ring[3] = corners[3 * u + (j + 2) % 3];
+    outer[0] = neighbors[3 * t + (k + 1) % 3];
+    outer[1] = neighbors[3 * t + (k + 2) % 3];
+    outer[2] = neighbors[3 * u + (j + 1) % 3];
+    outer[3] = neighbors[3 * u + (j + 2) % 3];
+    slots[0] = t, slots[1] = u, slots[2] = add(), slots[3] = add();
+  }
+  // the triangles around are relinked by edge rather than by which
+  // triangle they were next to, as the one across from a vertex with only
+  // three triangles around it borders both of the triangles split there
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t a = ring[i], b = ring[(i + 1) % count];
+    set(slots[i], v, a, b, slots[(i + count - 1) % count], outer[i]
+        , slots[(i + 1) % count]);
+    if (outer[i] != -1)
+      neighbors[3 * outer[i] + edge_from(corners.data(), outer[i], b, a)]
+        = slots[i];
+    stack.push_back(3 * slots[i] + 1);
+  }
+  *last = slots[0];
+
+  // every edge on the stack has v across from it
+  while (!stack.empty()) {
+    uint32_t h = stack.back(), s = h / 3, k = h % 3;
+    stack.pop_back();
+    int32_t u = neighbors[h];
+    if (u == -1 || corners[3 * s + (k + 2) % 3] != v)
+      continue;
+    uint32_t a = corners[h], b = corners[3 * s + (k + 1) % 3]
+      , j = edge_from(corners.data(), u, b, a);
+    if (j == 3)
+      continue;
+    uint32_t d = corners[3 * u + (j + 2) % 3];
+    if (incircle(points[v], points[a], points[b], points[d]) <= 0
+        || orient_at(v, a, d) <= 0 || orient_at(d, b, v) <= 0)
+      continue;
+    flip_edge(s, k, u, j);
+    stack.push_back(3 * s + 1);
+    stack.push_back(3 * u);
+  }
+  return true;
+}
+
+// the triangle with the edge from x to y, and which of its edges it is. the
+// triangles around a vertex of the enclosing triangle don't go all the way
+// round, so those are looked for from the other end
+bool delaunay_builder::find_edge(uint32_t x, uint32_t y, uint32_t *t
+    , uint32_t *k) const {
+  bool from_y = x >= n;
+  uint32_t pivot = from_y ? y : x, other = from_y ? x : y
+    , s = around[pivot];
+  for (size_t steps = 0; steps < corners.size(); steps++) {
+    uint32_t i = corner_of(s, pivot);
+    if (i == 3)
+      return false;
+    if (corners[3 * s + (i + 1) % 3] == other) {
+      if (!from_y) {
+        *t = s, *k = i;
+        return true;
+      }
+      int32_t u = neighbors[3 * s + i];
+      if (u == -1)
+        return false;
+      *t = u, *k = edge_from(corners.data(), u, other, pivot);
+      return *k != 3;
+    }
+    int32_t next = neighbors[3 * s + (i + 2) % 3];
+    if (next == -1 || (uint32_t)next == around[pivot])
+      return false;
+    s = next;
+  }
+  return false;
+}
+
+// makes ab an edge: finds the edges it crosses, and flips them one at a
+// time, coming back to those that can't be flipped yet. fails if ab runs
+// through a vertex or crosses another constraint, neither of which a simple
+// polygon has
+bool delaunay_builder::constrain(uint32_t a, uint32_t b) {
+  // on the same line as ab, and on the same side of a as b
+  auto ahead = [&](uint32_t x) {
+    const vec2<double> &pa = points[a], &pb = points[b], &px = points[x];
+    return pb.x != pa.x ? (px.x > pa.x) == (pb.x > pa.x)
+      : (px.y > pa.y) == (pb.y > pa.y);
+  };
+  uint32_t t = around[a], right = 0, left = 0;
+  for (size_t steps = 0;; steps++) {
+    uint32_t i = corner_of(t, a);
+    if (i == 3 || steps > corners.size())
+      return false;
+    right = corners[3 * t + (i + 1) % 3], left = corners[3 * t + (i + 2) % 3];
+    if (right == b || left == b)
+      return true;
+    double o_right = orient_at(a, right, b), o_left = orient_at(a, left, b);
+    if ((o_right == 0 && ahead(right)) || (o_left == 0 && ahead(left)))
+      return false;
+    if (o_right > 0 && o_left < 0)
+      break;
+    if (neighbors[3 * t + (i + 2) % 3] == -1)
+      return false;
+    t = neighbors[3 * t + (i + 2) % 3];
+  }
+
+  std::vector<std::pair<uint32_t, uint32_t>> crossed;
+  for (;;) {
+    if (constraint(right, left))
+      return false;
+    crossed.push_back({ right, left });
+    // the edge runs from right to left in the triangle on a's side of it,
+    // and back in the one beyond
+    uint32_t e = edge_from(corners.data(), t, right, left);
+    if (e == 3 || neighbors[3 * t + e] == -1)
+      return false;
+    t = neighbors[3 * t + e];
+    e = edge_from(corners.data(), t, left, right);
+    if (e == 3)
+      return false;
+    uint32_t w = corners[3 * t + (e + 2) % 3];
+    if (w == b)
+      break;
+    double o = orient_at(a, b, w);
+    if (o == 0)
+      return false;
+    if (o > 0)
+      left = w;
+    else
+      right = w;
+  }
+
+  std::deque<std::pair<uint32_t, uint32_t>> queue(crossed.begin()
+      , crossed.end());
+  size_t budget = 64 + 16 * crossed.size() * crossed.size();
+  while (!queue.empty()) {
+    if (budget-- == 0)
+      return false;
+    uint32_t x = queue.front().first, y = queue.front().second, k;
+    queue.pop_front();
+    if (!find_edge(x, y, &t, &k))
+      return false;
+    int32_t u = neighbors[3 * t + k];
+    uint32_t j = edge_from(corners.data(), u, y, x)
+      , cc = corners[3 * t + (k + 2) % 3], d = corners[3 * u + (j + 2) % 3];
+    if (orient_at(cc, x, d) <= 0 || orient_at(d, y, cc) <= 0) {
+      queue.push_back({ x, y });
+      continue;
+    }
+    flip_edge(t, k, u, j);
+    double o_c = orient_at(a, b, cc), o_d = orient_at(a, b, d);
+    if (cc != a && cc != b && d != a && d != b && o_c != 0 && o_d != 0
+        && (o_c > 0) != (o_d > 0))
+      queue.push_back({ cc, d });
+  }
+  return true;
+}
+
+// triangulates, constrains and then keeps the triangles inside the polygon,
+// the ones an odd number of constraints away from the outside. fails on
+// input that isn't a simple polygon
+bool delaunay_builder::build(mesh *m) {
+  double min_x = points[0].x, max_x = min_x, min_y = points[0].y
+    , max_y = min_y;
+  for (size_t i = 0; i < n; i++) {
+    min_x = std::min(min_x, points[i].x), max_x = std::max(max_x, points[i].x);
+    min_y = std::min(min_y, points[i].y), max_y = std::max(max_y, points[i].y);
+  }
+  double size = std::max(max_x - min_x, max_y - min_y);
+  if (!(size > 0) || std::isinf(size))
+    return false;
+  // far enough that the triangle it spans barely shows in the
+  // triangulation near the polygon
+  double cx = (min_x + max_x) / 2, cy = (min_y + max_y) / 2, far = 1024 * size;
+  points[n] = { cx - 2 * far, cy - far };
+  points[n + 1] = { cx + 2 * far, cy - far };
+  points[n + 2] = { cx, cy + 2 * far };
+  corners.reserve(3 * (2 * n + 1));
+  neighbors.reserve(3 * (2 * n + 1));
+  set(add(), n, n + 1, n + 2, -1, -1, -1);
+
+  std::vector<uint32_t> order(n);
+  for (size_t i = 0; i < n; i++)
+    order[i] = i;
+  std::mt19937 random(n);
+  std::shuffle(order.begin(), order.end(), random);
+  double scale_x = max_x > min_x ? 0xffff / (max_x - min_x) : 0
+    , scale_y = max_y > min_y ? 0xffff / (max_y - min_y) : 0;
+  std::vector<uint32_t> keys(n);
+  for (size_t i = 0; i < n; i++)
+    keys[i] = hilbert(std::min((points[i].x - min_x) * scale_x, 65535.)
+        , std::min((points[i].y - min_y) * scale_y, 65535.));
+  for (size_t begin = 0, end = std::min<size_t>(n, 64); begin < n
+      ; begin = end, end = std::min(n, 2 * end))
+    std::sort(order.begin() + begin, order.begin() + end
+        , [&](uint32_t x, uint32_t y) {
+          return keys[x] < keys[y];
+        });
+  uint32_t last = 0;
+  for (uint32_t v : order)
+    if (!insert(v, &last))
+      return false;
+  for (size_t i = 0; i < n; i++)
+    if (!constrain(i, rings.next[i]))
+      return false;
+
+  // 0-1 breadth first search for how many constraints every triangle is
+  // from the enclosing one
+  size_t triangles = corners.size() / 3;
+  std::vector<int32_t> depth(triangles, -1);
+  std::deque<uint32_t> queue;
+  depth[around[n]] = 0;
+  queue.push_back(around[n]);
+  while (!queue.empty()) {
+    uint32_t t = queue.front();
+    queue.pop_front();
+    for (uint32_t k = 0; k < 3; k++) {
+      int32_t u = neighbors[3 * t + k];
+      if (u == -1)
+        continue;
+      bool crosses = constraint(corners[3 * t + k]
+          , corners[3 * t + (k + 1) % 3]);
+      int32_t d = depth[t] + crosses;
+      if (depth[u] != -1 && depth[u] <= d)
+        continue;
+      depth[u] = d;
+      if (crosses)
+        queue.push_back(u);
+      else
+        queue.push_front(u);
+    }
+  }
+  std::vector<int32_t> kept(triangles, -1);
+  size_t count = 0;
+  for (size_t t = 0; t < triangles; t++)
+    if (depth[t] % 2 == 1)
+      kept[t] = count++;
+  if (count != max_triangles(n, rings.holes.size()))
+    return false;
+  m->corners.resize(3 * count);
+  m->neighbors.resize(3 * count);
+  for (size_t t = 0; t < triangles; t++) {
+    if (kept[t] == -1)
+      continue;
+    for (size_t k = 0; k < 3; k++) {
+      int32_t u = neighbors[3 * t + k];
+      m->corners[3 * kept[t] + k] = corners[3 * t + k];
+      m->neighbors[3 * kept[t] + k] = u == -1 ? -1 : kept[u];
+    }
+  }
+  return true;
+}
+
+// the triangulation is legalized once more at the end: constraining undoes
+// the delaunay property around the edges it flips, and the enclosing
+// triangle, not being infinitely far, leaves some of it out near the hull.
+// both are a few flips at most. input that isn't a simple polygon is swept
+// into monotone pieces instead and legalized from those
+template <typename T>
+void cdt_mesh(const vec2<T> *vertices, const polygon_rings &rings, mesh *m) {
+  size_t n = rings.n;
+  delaunay_builder builder(rings);
+  for (size_t i = 0; i < n; i++)
+    builder.points[i] = { (double)vertices[i].x, (double)vertices[i].y };
+  if (!builder.build(m)) {
+    size_t triangles = max_triangles(n, rings.holes.size());
+    m->corners.resize(3 * triangles);
+    index_sink sweep(m->corners.data(), nullptr, triangles);
+    monotone_triangulate(vertices, rings, &sweep);
+    m->corners.resize(3 * sweep.count);
+    m->neighbors.resize(m->corners.size());
+    build_neighbors(m->corners.data(), sweep.count, n, m->neighbors.data());
+  }
+  legalize(vertices, m);
+}
+
+template <typename T>
+void cdt_triangulate(const vec2<T> *vertices, const polygon_rings &rings
+    , index_sink *out) {
+  mesh m;
+  cdt_mesh(vertices, rings, &m);
+  for (size_t t = 0; 3 * t < m.corners.size(); t++)
+    out->emit(m.corners[3 * t], m.corners[3 * t + 1], m.corners[3 * t + 2]);
+  if (out->neighbors)
+    std::copy(m.neighbors.begin(), m.neighbors.end(), out->neighbors);
+}
+
+// legalizes the triangles already written to `out`, in place. the flips
+// only ever go as far as whatever the method made is from the constrained
+// delaunay triangulation, which for the sweep and the ear clipper on all but
+// contrived input is a few per vertex
+template <typename T>
+void delaunay_flip(const vec2<T> *vertices, size_t n, index_sink *out) {
+  mesh m;
+  m.corners.resize(3 * out->count);
+  for (size_t i = 0; i < m.corners.size(); i++)
+    m.corners[i] = out->corner(i);
+  m.neighbors.resize(m.corners.size());
+  build_neighbors(m.corners.data(), out->count, n, m.neighbors.data());
+  legalize(vertices, &m);
+  for (size_t i = 0; i < m.corners.size(); i++)
+    if (out->indices32)
+      out->indices32[i] = m.corners[i];
+    else
+      out->indices16[i] = (uint16_t)m.corners[i];
+  if (out->neighbors)
+    std::copy(m.neighbors.begin(), m.neighbors.end(), out->neighbors);
+}
+
+#define INSTANTIATE(T) \
+  template void legalize(const vec2<T> *vertices, mesh *m); \
+  template void cdt_mesh(const vec2<T> *vertices, const polygon_rings &rings \
+      , mesh *m); \
+  template void cdt_triangulate(const vec2<T> *vertices \
+      , const polygon_rings &rings, index_sink *out); \
+  template void delaunay_flip(const vec2<T> *vertices, size_t n \
+      , index_sink *out);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
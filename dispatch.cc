@@ -0,0 +1,155 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <chrono>
+
+template <typename T>
+polygon_stats measure_polygon(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes) {
+  polygon_stats stats;
+  stats.n = n;
+  stats.holes = holes;
+  stats.reflex = 0;
+  stats.convex = false;
+  stats.aspect = 1;
+  stats.area = 0;
+  if (n < 3)
+    return stats;
+  // turns to either side on every ring, and wraps of the outer one as in
+  // is_convex(). which side is reflex is only known once the area is
+  size_t left = 0, right = 0, straight = 0, wraps = 0;
+  double x0 = (double)vertices[0].x, y0 = (double)vertices[0].y
+    , min_x = x0, max_x = x0, min_y = y0, max_y = y0, area = 0;
+  auto lower = [](const vec2<T> &a, const vec2<T> &b) {
+    return b.y < a.y || (b.y == a.y && b.x < a.x);
+  };
+  for (size_t k = 0; k <= holes; k++) {
+    size_t first = k == 0 ? 0 : hole_starts[k - 1]
+      , end = k == holes ? n : hole_starts[k];
+    const vec2<T> *prev = &vertices[end - 1];
+    bool was_lower = lower(*prev, vertices[first]);
+    for (size_t i = first; i < end; i++) {
+      const vec2<T> &a = vertices[i]
+        , &b = vertices[i + 1 == end ? first : i + 1];
+      auto turn = orient(*prev, a, b);
+      left += turn > 0, right += turn < 0, straight += turn == 0;
+      prev = &a;
+      min_x = std::min(min_x, (double)a.x);
+      max_x = std::max(max_x, (double)a.x);
+      min_y = std::min(min_y, (double)a.y);
+      max_y = std::max(max_y, (double)a.y);
+      if (k != 0)
+        continue;
+      area += ((double)a.x - x0) * ((double)b.y - y0)
+        - ((double)a.y - y0) * ((double)b.x - x0);
+      bool is_lower = lower(a, b);
+      wraps += is_lower && !was_lower;
+      was_lower = is_lower;
+    }
+  }
+  stats.area = area / 2;
+  stats.reflex = stats.area < 0 ? left : right;
+  stats.convex = holes == 0 && stats.reflex == 0 && straight == 0
+    && wraps == 1;
+  double width = max_x - min_x, height = max_y - min_y;
+  stats.aspect = std::min(width, height) > 0
+    ? std::max(width, height) / std::min(width, height) : HUGE_VAL;
+  return stats;
+}
+
+int choose_method(const polygon_stats &stats
+    , const dispatch_thresholds &thresholds) {
+  if (stats.convex)
+    return StackBased;
+  if (stats.holes == 0 && stats.n <= thresholds.earclip_vertices
+      && stats.reflex <= thresholds.earclip_reflex
+      && stats.aspect <= thresholds.earclip_aspect)
+    return EarClipping;
+  return MonotoneSweep;
+}
+
+// a circle of n vertices, `reflex` of them spread out evenly and pushed in
+// far enough to turn the other way, stretched `aspect` times along x
+static std::vector<vec2<double>> dented_circle(size_t n, size_t reflex
+    , double aspect) {
+  std::vector<vec2<double>> v(n);
+  size_t next_dent = 0, dents = 0;
+  for (size_t i = 0; i < n; i++) {
+    double r = 1, a = 2 * M_PI * i / n;
+    if (dents < reflex && i == next_dent) {
+      r = 0.7;
+      next_dent = ++dents * n / reflex;
+    }
+    v[i] = { aspect * r * std::cos(a), r * std::sin(a) };
+  }
+  return v;
+}
+
+// nanoseconds `method` takes on `v`, the best of a few runs of enough
+// repetitions to outlast the clock's resolution
+static double time_method(const std::vector<vec2<double>> &v, int method) {
+  std::vector<uint32_t> indices(3 * max_triangles(v.size()));
+  triangulate_options options(method);
+  size_t repeats = std::max<size_t>(16, (1 << 17) / v.size());
+  double best = HUGE_VAL;
+  for (int run = 0; run < 5; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repeats; r++)
+      triangulate(v.data(), v.size(), options, indices.data());
+    std::chrono::duration<double, std::nano> took
+      = std::chrono::steady_clock::now() - start;
+    best = std::min(best, took.count() / repeats);
+  }
+  return best;
+}
+
+static bool earclip_wins(size_t n, size_t reflex, double aspect) {
+  std::vector<vec2<double>> v = dented_circle(n, reflex, aspect);
+  return time_method(v, EarClipping) < time_method(v, MonotoneSweep);
+}
+
+// every limit is the last setting the ear clipper won at before it lost
+// twice in a row, which rides out a stray slow run
+dispatch_thresholds calibrate_dispatch() {
+  dispatch_thresholds thresholds;
+  const size_t max_vertices = 256;
+  size_t last = 0, losses = 0;
+  for (size_t n = 8; n <= max_vertices && losses < 2; n += 8) {
+    if (earclip_wins(n, std::max<size_t>(n / 8, 1), 1))
+      last = n, losses = 0;
+    else
+      losses++;
+  }
+  thresholds.earclip_vertices = last;
+  if (last == 0)
+    return thresholds;
+  // the other two are looked for at half that size, since at the crossover
+  // itself both methods take about as long whatever the shape
+  size_t n = std::max<size_t>(last / 2, 4);
+  last = 0, losses = 0;
+  for (size_t reflex = 1; reflex <= n / 2 && losses < 2; reflex++) {
+    if (earclip_wins(n, reflex, 1))
+      last = reflex, losses = 0;
+    else
+      losses++;
+  }
+  thresholds.earclip_reflex = last;
+  size_t reflex = std::max<size_t>(std::min(last, n / 8), 1);
+  double last_aspect = 1;
+  losses = 0;
+  for (double aspect = 2; aspect <= 1024 && losses < 2; aspect *= 2) {
+    if (earclip_wins(n, reflex, aspect))
+      last_aspect = aspect, losses = 0;
+    else
+      losses++;
+  }
+  thresholds.earclip_aspect = last_aspect == 1024 ? HUGE_VAL : last_aspect;
+  return thresholds;
+}
+
+#define INSTANTIATE(T) \
+  template polygon_stats measure_polygon(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
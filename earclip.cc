@@ -0,0 +1,529 @@
+#include "triangulators.hh"
+#include "simd.hh"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// the polygon is kept as a doubly linked ring of nodes allocated from a single
+// pool. every vertex is reflex (or flat, which can block an ear just the
+// same) or convex, and clipping one changes nothing but the state of its two
+// neighbours. the convex vertices are threaded onto a second ring of their
+// own, in the same order, where the neighbours of a clipped vertex that turn
+// convex take its place. that ring is walked around as earcut walks the
+// polygon: a vertex is tested when the walk gets to it, and after every ear
+// the walk carries on past the next vertex. that keeps the ears small and
+// close to one another, where starting over at some ear found earlier would
+// fan long diagonals out from one vertex, and every one of them would have
+// to be tested against most of the polygon. and the walk doesn't have to
+// step over every reflex vertex again each time around.
+//
+// an ear candidate only has to be tested against the reflex vertices, since
+// a convex vertex can't lie inside an ear without a reflex one lying in it
+// too. their coordinates are copied into separate x and y arrays, so that the
+// test runs over eight of them at a time, and the slots of vertices that stop
+// being reflex are overwritten with nans, which fail every comparison (with
+// integer coordinates, which have no nans, a slot is checked against its node
+// instead). the arrays are compacted whenever more than half of them is dead.
+// the vector test is single precision only, other coordinate types get the
+// exact test alone.
+//
+// holes come in already bridged to the outer ring, so that both ends of every
+// bridge are visited twice. an ear is never blocked by another visit of one
+// of its own corners.
+//
+// for large polygons the reflex vertices can also be sorted along a z-order
+// curve over the bounding box. every quadtree cell of the grid the codes are
+// taken on is then a slice of the arrays, found by binary search. an ear goes
+// down from the smallest cell holding its bounding box and only into the
+// cells it overlaps, which leaves out most of the slice between the corners
+// of a long thin ear at an angle, and tests the points of a cell directly
+// once there are only a few of them left
+
+static const uint32_t none = UINT32_MAX;
+
+// cells of the z-order index with no more reflex vertices than this are
+// tested point by point rather than split further
+static const uint32_t leaf_slots = 16;
+
+// the x coordinate of a morton code, and the y one of the code shifted right
+// once
+static uint32_t unmorton(uint32_t code) {
+  code &= 0x55555555;
+  code = (code | (code >> 1)) & 0x33333333;
+  code = (code | (code >> 2)) & 0x0f0f0f0f;
+  code = (code | (code >> 4)) & 0x00ff00ff;
+  return (code | (code >> 8)) & 0x0000ffff;
+}
+
+template <typename T>
+static bool same(const vec2<T> &a, const vec2<T> &b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+enum ear_state
+{
+  convex_vertex,
+  reflex_vertex
+};
+
+struct ear_node
+{
+  uint32_t index, prev, next;
+  uint32_t convex_prev, convex_next;
+  uint32_t slot;
+  uint8_t state;
+};
+
+// the three edge functions of an ear in single precision, each allowed to
+// come out slightly negative. the slack covers their rounding error for any
+// point within the ear's bounding box, so a point that's really inside is
+// never missed, and whatever passes is checked again with orient()
+struct ear_filter
+{
+  float ax, ay, bx, by, cx, cy;
+  float dx[3], dy[3], slack[3];
+
+  ear_filter(const vertex &a, const vertex &b, const vertex &c)
+    : ax(a.x), ay(a.y), bx(b.x), by(b.y), cx(c.x), cy(c.y) {
+    float w = std::max(a.x, std::max(b.x, c.x))
+      - std::min(a.x, std::min(b.x, c.x))
+      , h = std::max(a.y, std::max(b.y, c.y))
+      - std::min(a.y, std::min(b.y, c.y));
+    dx[0] = bx - ax, dy[0] = by - ay;
+    dx[1] = cx - bx, dy[1] = cy - by;
+    dx[2] = ax - cx, dy[2] = ay - cy;
+    const float eps = std::numeric_limits<float>::epsilon();
+    for (int k = 0; k < 3; k++)
+      slack[k] = -8 * eps * (std::fabs(dx[k]) * h + std::fabs(dy[k]) * w);
+  }
+  bool test(float px, float py) const {
+    return dx[0] * (py - ay) - dy[0] * (px - ax) >= slack[0]
+      && dx[1] * (py - by) - dy[1] * (px - bx) >= slack[1]
+      && dx[2] * (py - cy) - dy[2] * (px - cx) >= slack[2];
+  }
+};
+
+// returns the first slot in [slot, end) that passes the filter, or end
+typedef uint32_t (*ear_scan)(const float *x, const float *y, uint32_t slot
+    , uint32_t end, const ear_filter &f);
+
+static uint32_t scan_scalar(const float *x, const float *y, uint32_t slot
+    , uint32_t end, const ear_filter &f) {
+  for (; slot < end; slot++)
+    if (f.test(x[slot], y[slot]))
+      return slot;
+  return end;
+}
+
+#ifdef SIMD_X86
+static uint32_t scan_sse2(const float *x, const float *y, uint32_t slot
+    , uint32_t end, const ear_filter &f) {
+  const __m128 ax = _mm_set1_ps(f.ax), ay = _mm_set1_ps(f.ay)
+    , bx = _mm_set1_ps(f.bx), by = _mm_set1_ps(f.by)
+    , cx = _mm_set1_ps(f.cx), cy = _mm_set1_ps(f.cy)
+    , dx0 = _mm_set1_ps(f.dx[0]), dy0 = _mm_set1_ps(f.dy[0])
+    , dx1 = _mm_set1_ps(f.dx[1]), dy1 = _mm_set1_ps(f.dy[1])
+    , dx2 = _mm_set1_ps(f.dx[2]), dy2 = _mm_set1_ps(f.dy[2])
+    , s0 = _mm_set1_ps(f.slack[0]), s1 = _mm_set1_ps(f.slack[1])
+    , s2 = _mm_set1_ps(f.slack[2]);
+  for (; slot + 4 <= end; slot += 4) {
+    __m128 px = _mm_loadu_ps(x + slot), py = _mm_loadu_ps(y + slot);
+    __m128 e0 = _mm_sub_ps(_mm_mul_ps(dx0, _mm_sub_ps(py, ay))
+        , _mm_mul_ps(dy0, _mm_sub_ps(px, ax)))
+      , e1 = _mm_sub_ps(_mm_mul_ps(dx1, _mm_sub_ps(py, by))
+        , _mm_mul_ps(dy1, _mm_sub_ps(px, bx)))
+      , e2 = _mm_sub_ps(_mm_mul_ps(dx2, _mm_sub_ps(py, cy))
+        , _mm_mul_ps(dy2, _mm_sub_ps(px, cx)));
+    int mask = _mm_movemask_ps(_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, s0)
+            , _mm_cmpge_ps(e1, s1)), _mm_cmpge_ps(e2, s2)));
+    if (mask)
+      return slot + __builtin_ctz(mask);
+  }
+  return scan_scalar(x, y, slot, end, f);
+}
+
+TARGET_AVX2
+static uint32_t scan_avx2(const float *x, const float *y, uint32_t slot
+    , uint32_t end, const ear_filter &f) {
+  const __m256 ax = _mm256_set1_ps(f.ax), ay = _mm256_set1_ps(f.ay)
+    , bx = _mm256_set1_ps(f.bx), by = _mm256_set1_ps(f.by)
+    , cx = _mm256_set1_ps(f.cx), cy = _mm256_set1_ps(f.cy)
+    , dx0 = _mm256_set1_ps(f.dx[0]), dy0 = _mm256_set1_ps(f.dy[0])
+    , dx1 = _mm256_set1_ps(f.dx[1]), dy1 = _mm256_set1_ps(f.dy[1])
+    , dx2 = _mm256_set1_ps(f.dx[2]), dy2 = _mm256_set1_ps(f.dy[2])
+    , s0 = _mm256_set1_ps(f.slack[0]), s1 = _mm256_set1_ps(f.slack[1])
+    , s2 = _mm256_set1_ps(f.slack[2]);
+  for (; slot + 8 <= end; slot += 8) {
+    __m256 px = _mm256_loadu_ps(x + slot), py = _mm256_loadu_ps(y + slot);
+    __m256 e0 = _mm256_sub_ps(_mm256_mul_ps(dx0, _mm256_sub_ps(py, ay))
+        , _mm256_mul_ps(dy0, _mm256_sub_ps(px, ax)))
+      , e1 = _mm256_sub_ps(_mm256_mul_ps(dx1, _mm256_sub_ps(py, by))
+        , _mm256_mul_ps(dy1, _mm256_sub_ps(px, bx)))
+      , e2 = _mm256_sub_ps(_mm256_mul_ps(dx2, _mm256_sub_ps(py, cy))
+        , _mm256_mul_ps(dy2, _mm256_sub_ps(px, cx)));
+    int mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(
+            _mm256_cmp_ps(e0, s0, _CMP_GE_OQ)
+            , _mm256_cmp_ps(e1, s1, _CMP_GE_OQ))
+          , _mm256_cmp_ps(e2, s2, _CMP_GE_OQ)));
+    if (mask)
+      return slot + __builtin_ctz(mask);
+  }
+  return scan_sse2(x, y, slot, end, f);
+}
+#endif
+
+static ear_scan pick_ear_scan() {
+#ifdef SIMD_X86
+  return cpu_has_avx2() ? scan_avx2 : scan_sse2;
+#else
+  return scan_scalar;
+#endif
+}
+
+template <typename T>
+struct ear_ring
+{
+  const vec2<T> *vertices;
+  std::vector<ear_node> nodes;
+  bool zorder;
+  double min_x, min_y, scale_x, scale_y;
+  // the reflex vertices, with their nodes and morton codes
+  std::vector<T> xs, ys;
+  std::vector<uint32_t> slot_nodes, zcodes;
+  std::vector<std::pair<uint32_t, uint32_t>> sorted;
+  size_t dead;
+  // the triangle across the edge from every node to the next one, -1 for
+  // edges of the polygon. kept only when the output wants the neighbours
+  std::vector<int32_t> across;
+
+  const vec2<T> &at(uint32_t node) const {
+    return vertices[nodes[node].index];
+  }
+  bool is_reflex(uint32_t node) const {
+    const ear_node &e = nodes[node];
+    return orient(at(e.prev), at(node), at(e.next)) <= 0;
+  }
+  // puts `node` on the ring of convex vertices after `last`, or on a ring of
+  // its own when there's no last
+  void link_convex(uint32_t node, uint32_t last) {
+    ear_node &e = nodes[node];
+    e.state = convex_vertex;
+    if (last == none) {
+      e.convex_prev = e.convex_next = node;
+      return;
+    }
+    e.convex_prev = last;
+    e.convex_next = nodes[last].convex_next;
+    nodes[e.convex_next].convex_prev = node;
+    nodes[last].convex_next = node;
+  }
+  // takes `node` off the ring of convex vertices, and returns the one before
+  // it, or none if it was the last
+  uint32_t unlink_convex(uint32_t node) {
+    ear_node &e = nodes[node];
+    e.state = reflex_vertex;
+    if (e.convex_prev == node)
+      return none;
+    nodes[e.convex_prev].convex_next = e.convex_next;
+    nodes[e.convex_next].convex_prev = e.convex_prev;
+    return e.convex_prev;
+  }
+  // called on the neighbours of every clipped vertex in turn. `last` is the
+  // convex vertex that comes before `node`, or none if there are none left,
+  // and becomes `node` itself if that is convex. on a simple polygon they
+  // can only go from reflex to convex, but the forced clips below can move
+  // them either way
+  void classify(uint32_t node, uint32_t *last) {
+    ear_node &e = nodes[node];
+    if (is_reflex(node)) {
+      if (e.state == convex_vertex) {
+        uint32_t before = unlink_convex(node);
+        if (*last == node)
+          *last = before;
+      }
+      return;
+    }
+    if (e.state == convex_vertex) {
+      *last = node;
+      return;
+    }
+    link_convex(node, *last);
+    *last = node;
+    // out of the reflex arrays, or it would block itself
+    if (e.slot != none) {
+      if (std::numeric_limits<T>::has_quiet_NaN)
+        xs[e.slot] = ys[e.slot] = std::numeric_limits<T>::quiet_NaN();
+      e.slot = none;
+      dead++;
+    }
+    if (dead > 32 && 2 * dead > xs.size())
+      compact();
+  }
+  uint32_t zcode(double x, double y) const {
+    double zx = (x - min_x) * scale_x, zy = (y - min_y) * scale_y;
+    return morton(zx <= 0 ? 0 : zx >= 65535 ? 65535 : (uint32_t)zx
+        , zy <= 0 ? 0 : zy >= 65535 ? 65535 : (uint32_t)zy);
+  }
+  // copies out the vertices that are reflex at the start. on a simple
+  // polygon no others ever turn reflex, only after a forced clip, and by then
+  // the containment test doesn't matter much anyway
+  void index_reflex(size_t n) {
+    if (zorder) {
+      double max_x = at(0).x, max_y = at(0).y;
+      min_x = max_x, min_y = max_y;
+      for (size_t i = 1; i < n; i++) {
+        min_x = std::min(min_x, (double)at(i).x);
+        min_y = std::min(min_y, (double)at(i).y);
+        max_x = std::max(max_x, (double)at(i).x);
+        max_y = std::max(max_y, (double)at(i).y);
+      }
+      // stretched to the bounding box both ways, or a long thin polygon
+      // would only take up a row or two of the grid
+      scale_x = max_x > min_x ? 65535 / (max_x - min_x) : 0;
+      scale_y = max_y > min_y ? 65535 / (max_y - min_y) : 0;
+    }
+    sorted.clear();
+    for (size_t i = 0; i < n; i++)
+      if (nodes[i].state == reflex_vertex)
+        sorted.push_back({ zorder ? zcode(at(i).x, at(i).y) : 0
+            , (uint32_t)i });
+    if (zorder)
+      std::sort(sorted.begin(), sorted.end());
+    xs.resize(sorted.size());
+    ys.resize(sorted.size());
+    slot_nodes.resize(sorted.size());
+    zcodes.resize(sorted.size());
+    for (size_t s = 0; s < sorted.size(); s++) {
+      zcodes[s] = sorted[s].first;
+      slot_nodes[s] = sorted[s].second;
+      xs[s] = at(slot_nodes[s]).x;
+      ys[s] = at(slot_nodes[s]).y;
+      nodes[slot_nodes[s]].slot = s;
+    }
+    dead = 0;
+  }
+  void compact() {
+    size_t live = 0;
+    for (size_t s = 0; s < xs.size(); s++) {
+      uint32_t node = slot_nodes[s];
+      if (nodes[node].slot != s)
+        continue;
+      xs[live] = xs[s];
+      ys[live] = ys[s];
+      zcodes[live] = zcodes[s];
+      slot_nodes[live] = node;
+      nodes[node].slot = live++;
+    }
+    xs.resize(live);
+    ys.resize(live);
+    zcodes.resize(live);
+    slot_nodes.resize(live);
+    dead = 0;
+  }
+  // exact test of the point in `slot` against ear abc. a dead slot fails it,
+  // and so do the ear's own corners, visited once more or not
+  bool blocks(uint32_t slot, const vec2<T> &a, const vec2<T> &b
+      , const vec2<T> &c) const {
+    if (!std::numeric_limits<T>::has_quiet_NaN
+        && nodes[slot_nodes[slot]].slot != slot)
+      return false;
+    vec2<T> p = { xs[slot], ys[slot] };
+    return orient(a, b, p) >= 0 && orient(b, c, p) >= 0
+      && orient(c, a, p) >= 0 && !same(p, a) && !same(p, b) && !same(p, c);
+  }
+  // whether any slot in [slot, end) blocks ear abc
+  bool blocked(uint32_t slot, uint32_t end, const vec2<T> &a
+      , const vec2<T> &b, const vec2<T> &c) const {
+    for (; slot < end; slot++)
+      if (blocks(slot, a, b, c))
+        return true;
+    return false;
+  }
+  // whether the cell of the grid from (x, y) on, `side` long, overlaps the
+  // ear with corners `gx` and `gy` in the grid. it's made a little bigger
+  // first, which covers any rounding in the coordinates
+  static bool overlaps(const double *gx, const double *gy, double x, double y
+      , double side) {
+    const double margin = 1. / 64;
+    double x0 = x - margin, y0 = y - margin, x1 = x + side + margin
+      , y1 = y + side + margin;
+    if (std::max(gx[0], std::max(gx[1], gx[2])) < x0
+        || std::min(gx[0], std::min(gx[1], gx[2])) > x1
+        || std::max(gy[0], std::max(gy[1], gy[2])) < y0
+        || std::min(gy[0], std::min(gy[1], gy[2])) > y1)
+      return false;
+    // outside if even the corner furthest to the left of an edge is right
+    // of it
+    for (int k = 0; k < 3; k++) {
+      int l = k == 2 ? 0 : k + 1;
+      double dx = gx[l] - gx[k], dy = gy[l] - gy[k];
+      double cx = dy < 0 ? x1 : x0, cy = dx > 0 ? y1 : y0;
+      if (dx * (cy - gy[k]) - dy * (cx - gx[k]) < 0)
+        return false;
+    }
+    return true;
+  }
+  // whether any slot in [slot, end) blocks ear abc, those being the points
+  // in the cell of 2^bits codes from `code` on, which starts at (x, y) in
+  // the grid
+  bool blocked_in(uint32_t slot, uint32_t end, uint32_t code, int bits
+      , uint32_t x, uint32_t y, const double *gx, const double *gy
+      , const vec2<T> &a, const vec2<T> &b, const vec2<T> &c) const {
+    if (end - slot <= leaf_slots || bits == 0)
+      return blocked(slot, end, a, b, c);
+    if (!overlaps(gx, gy, x, y, (double)(1u << bits / 2)))
+      return false;
+    bits -= 2;
+    uint32_t half = 1u << bits / 2;
+    for (uint32_t k = 0; k < 4 && slot < end; k++) {
+      uint32_t split = k == 3 ? end : std::lower_bound(zcodes.begin() + slot
+          , zcodes.begin() + end, code + ((k + 1) << bits)) - zcodes.begin();
+      if (split > slot && blocked_in(slot, split, code + (k << bits), bits
+            , x + (k & 1) * half, y + (k >> 1) * half, gx, gy, a, b, c))
+        return true;
+      slot = split;
+    }
+    return false;
+  }
+  bool is_ear(uint32_t node) const {
+    const ear_node &e = nodes[node];
+    const vec2<T> &a = at(e.prev), &b = at(node), &c = at(e.next);
+    if (!zorder)
+      return !blocked(0, xs.size(), a, b, c);
+    uint32_t lo = zcode(std::min(a.x, std::min(b.x, c.x))
+        , std::min(a.y, std::min(b.y, c.y)))
+      , hi = zcode(std::max(a.x, std::max(b.x, c.x))
+        , std::max(a.y, std::max(b.y, c.y)));
+    // the smallest cell both corners of the bounding box are in
+    int bits = lo == hi ? 0 : (32 - __builtin_clz(lo ^ hi) + 1) & ~1;
+    uint64_t first = bits == 32 ? 0 : lo & ~((1u << bits) - 1)
+      , last = first + ((uint64_t)1 << bits);
+    uint32_t slot = std::lower_bound(zcodes.begin(), zcodes.end(), first)
+      - zcodes.begin();
+    uint32_t end = last > UINT32_MAX ? zcodes.size()
+      : std::lower_bound(zcodes.begin() + slot, zcodes.end(), last)
+      - zcodes.begin();
+    double gx[3], gy[3];
+    const vec2<T> *corners[3] = { &a, &b, &c };
+    for (int k = 0; k < 3; k++) {
+      gx[k] = ((double)corners[k]->x - min_x) * scale_x;
+      gy[k] = ((double)corners[k]->y - min_y) * scale_y;
+    }
+    return !blocked_in(slot, end, (uint32_t)first, bits
+        , unmorton((uint32_t)first), unmorton((uint32_t)first >> 1), gx, gy
+        , a, b, c);
+  }
+};
+
+// float coordinates go through the vector filter first
+template <>
+bool ear_ring<float>::blocked(uint32_t slot, uint32_t end, const vertex &a
+    , const vertex &b, const vertex &c) const {
+  static const ear_scan scan = pick_ear_scan();
+  // a few candidates aren't worth setting the filter up for
+  if (end - slot < 8) {
+    for (; slot < end; slot++)
+      if (blocks(slot, a, b, c))
+        return true;
+    return false;
+  }
+  ear_filter f(a, b, c);
+  for (; (slot = scan(xs.data(), ys.data(), slot, end, f)) != end; slot++)
+    if (blocks(slot, a, b, c))
+      return true;
+  return false;
+}
+
+// makes triangles t and u neighbours across edge k of t, u being an ear
+// clipped earlier whose diagonal that is
+static void link(index_sink *out, int32_t t, int k, int32_t u) {
+  out->link(t, k, u);
+  out->link(u, 2, t);
+}
+
+template <typename T>
+void earclip_triangulate(const vec2<T> *vertices, const uint32_t *order
+    , size_t n, bool zorder, index_sink *out) {
+  // small polygons reuse the buffers of the last one clipped on the same
+  // thread, which saves a batch of them most of its allocations
+  static thread_local ear_ring<T> kept;
+  ear_ring<T> fresh;
+  ear_ring<T> &ring = n <= 4096 ? kept : fresh;
+  ring.vertices = vertices;
+  ring.nodes.resize(n);
+  ring.zorder = zorder;
+  for (size_t i = 0; i < n; i++) {
+    ear_node &e = ring.nodes[i];
+    e.index = order ? order[i] : i;
+    e.prev = i == 0 ? n - 1 : i - 1;
+    e.next = i + 1 == n ? 0 : i + 1;
+    e.slot = none;
+    e.state = convex_vertex;
+  }
+  uint32_t last = none;
+  for (size_t i = 0; i < n; i++)
+    if (ring.is_reflex(i))
+      ring.nodes[i].state = reflex_vertex;
+    else {
+      ring.link_convex(i, last);
+      last = i;
+    }
+  ring.index_reflex(n);
+  if (out->neighbors)
+    ring.across.assign(n, -1);
+
+  // going all the way around from the last ear without finding another means
+  // the input isn't a simple ccw polygon. then a convex vertex is clipped
+  // without the containment test, and failing that any vertex at all, so
+  // that the output is still complete
+  size_t remaining = n;
+  uint32_t node = last == none ? none : ring.nodes[last].convex_next
+    , stop = node, alive = 0;
+  while (remaining > 3) {
+    if (node == none)
+      node = alive;
+    else if (!ring.is_ear(node)) {
+      node = ring.nodes[node].convex_next;
+      if (node != stop)
+        continue;
+    }
+    const ear_node &e = ring.nodes[node];
+    uint32_t prev = e.prev, next = e.next;
+    int32_t t = out->count;
+    out->emit(ring.nodes[prev].index, e.index, ring.nodes[next].index);
+    // the ear's third edge is the diagonal it leaves behind, whose other side
+    // is clipped later on
+    if (out->neighbors) {
+      link(out, t, 0, ring.across[prev]);
+      link(out, t, 1, ring.across[node]);
+      out->link(t, 2, -1);
+      ring.across[prev] = t;
+    }
+    // prev and next go where the ear was on the ring of convex vertices
+    last = e.state == convex_vertex ? ring.unlink_convex(node) : none;
+    ring.nodes[prev].next = next;
+    ring.nodes[next].prev = prev;
+    remaining--;
+    ring.classify(prev, &last);
+    ring.classify(next, &last);
+    alive = next;
+    // carry on past the next vertex rather than at it, clipping straight on
+    // from `prev` would fan out long slivers
+    node = stop = last == none ? none : ring.nodes[last].convex_next;
+  }
+  const ear_node &e = ring.nodes[alive];
+  int32_t t = out->count;
+  out->emit(ring.nodes[e.prev].index, e.index, ring.nodes[e.next].index);
+  if (out->neighbors) {
+    link(out, t, 0, ring.across[e.prev]);
+    link(out, t, 1, ring.across[alive]);
+    link(out, t, 2, ring.across[e.next]);
+  }
+}
+
+template void earclip_triangulate(const vec2<float> *vertices
+    , const uint32_t *order, size_t n, bool zorder, index_sink *out);
+template void earclip_triangulate(const vec2<double> *vertices
+    , const uint32_t *order, size_t n, bool zorder, index_sink *out);
+template void earclip_triangulate(const vec2<int32_t> *vertices
+    , const uint32_t *order, size_t n, bool zorder, index_sink *out);
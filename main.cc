@@ -1,4 +1,5 @@
 #include "ogl.hh"
+#include "poly2tri.hh"
 #include "screen.hh"
 #include "utils.hh"
 #include "imgui/imgui.h"
@@ -6,33 +7,10 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
 #include <algorithm>
-#include <stack>
 
-enum method
-{
-  StackBased = 0,
-  HorizontalSweep = 1,
-  EarClipping = 2
-};
-
-template <typename T>
-struct vec2
-{
-  T x, y;
-};
-typedef vec2<float> vertex;
-
-struct polygon
-{
-  std::vector<vertex> vertices;
-};
 static polygon mainpoly;
 
-struct triangule_soup
-{
-  std::vector<polygon> triangles;
-};
-static triangule_soup triangulation_result;
+static std::vector<uint32_t> triangulation_result;
 static bool draw_tri = false;
 
 static int mouse_x = 0, mouse_y = 0;
@@ -236,109 +214,6 @@ void mousebutton_event(int button, bool down) {
   }
 }
 
-void triangulate(int method) {
-  if (mainpoly.vertices.size() < 3)
-    return;
-  triangulation_result.triangles.clear();
-
-  if (method == StackBased) {
-    std::stack<vertex> vertices;
-    for (const vertex &v : mainpoly.vertices)
-      vertices.push(v);
-    const vertex &v0 = vertices.top();
-    vertices.pop();
-    vertex &vh = vertices.top();
-    vertices.pop();
-    while (!vertices.empty()) {
-      const vertex &vt = vertices.top();
-      vertices.pop();
-      triangulation_result.triangles.push_back({ { v0, vh, vt } });
-      vh = vt;
-    }
-  } else if (method == HorizontalSweep) {
-    std::vector<vertex> vertices = mainpoly.vertices;
-    std::sort(vertices.begin(), vertices.end()
-        , [](const vertex &a, const vertex &b) {
-          return a.x > b.x;
-        });
-    std::stack<vertex> vert_stack;
-    for (const vertex &v : vertices)
-      vert_stack.push(v);
-    vertex &v1 = vert_stack.top();
-    vert_stack.pop();
-    vertex &v2 = vert_stack.top();
-    vert_stack.pop();
-    while (!vert_stack.empty()) {
-      const vertex &vt = vert_stack.top();
-      vert_stack.pop();
-      triangulation_result.triangles.push_back({ { v1, v2, vt } });
-      v1 = v2;
-      v2 = vt;
-    }
-  } else if (method == EarClipping) {
-    std::vector<vertex> vertices = mainpoly.vertices;
-    while (1) {
-      bool ear_found = false;
-      if (vertices.size() == 3) {
-        triangulation_result.triangles.push_back({ vertices });
-        break;
-      }
-      for (size_t curr = 0; curr < vertices.size(); curr++) {
-        size_t prev, next, size = vertices.size();
-        if (curr == 0) {
-          prev = size - 1;
-          next = 1;
-        } else if (curr == size - 1) {
-          prev = size - 2;
-          next = 0;
-        } else {
-          prev = curr - 1;
-          next = curr + 1;
-        }
-        const vertex &pv = vertices[prev], &cv = vertices[curr]
-          , &nv = vertices[next];
-        auto vertex_is_concave =
-          [](const vertex &p, const vertex &c, const vertex &n) {
-            float area_sum = 0;
-            area_sum += p.x * (n.y - c.y);
-            area_sum += c.x * (p.y - n.y);
-            area_sum += n.x * (c.y - p.y);
-            return (area_sum > 0);
-          };
-        if (vertex_is_concave(pv, cv, nv))
-          continue;
-        auto vertex_in_triangle = [](const vertex &test, const vertex &v1
-            , const vertex &v2, const vertex &v3) {
-          float x = test.x, y = test.y, x1 = v1.x, y1 = v1.y
-            , x2 = v2.x, y2 = v2.y, x3 = v3.x, y3 = v3.y;
-          float d = (x1 * (y2 - y3) + y1 * (x3 - x2) + x2 * y3 - y2 * x3)
-            , t1 = (x * (y3 - y1) + y * (x1 - x3) - x1 * y3 + y1 * x3) / d
-            , t2 = (x * (y2 - y1) + y * (x1 - x2) - x1 * y2 + y1 * x2) / -d
-            , s = t1 + t2;
-          return 0 <= t1 && t1 <= 1 && 0 <= t2 && t2 <= 1 && s <= 1;
-        };
-        bool has_vertices_in_triangle = false;
-        for (size_t j = 0; j < size; j++) {
-          if (j == prev || j == curr || j == next)
-            continue;
-          if (vertex_in_triangle(vertices[j], pv, cv, nv)) {
-            has_vertices_in_triangle = true;
-            break;
-          }
-        }
-        if (has_vertices_in_triangle)
-          continue;
-        ear_found = true;
-        triangulation_result.triangles.push_back({ { pv, cv, nv } });
-        vertices.erase(vertices.begin() + curr);
-        break;
-      }
-      if (!ear_found)
-        break;
-    }
-  }
-}
-
 void update(double dt, double t, screen *s) {
   ImGuiIO& io = ImGui::GetIO();
   io.DeltaTime = dt / 1000.;
@@ -404,16 +279,22 @@ void draw(double alpha) {
   static int method = 0;
   ImGui::Text(" ");
   ImGui::Text("Triangulation method");
-  ImGui::Combo("", &method, "Stack based\0Horizontal sweep\0Ear clipping\0");
+  ImGui::Combo("", &method, "Stack based\0Monotone sweep\0Ear clipping\0"
+      "Constrained Delaunay\0Seidel trapezoidation\0Automatic\0");
   if (method == StackBased)
     ImGui::TextWrapped("Warning: Stack based triangulation algorithm works only "
         "on convex polygons");
-  else if (method == HorizontalSweep)
-    ImGui::TextWrapped("Warning: Horizontal sweep algorithm is not finished: it"
-        " produces wrong shapes for special cases and works only on convex"
-        " polygons");
+  bool simple = is_simple(mainpoly.vertices.data()
+      , mainpoly.vertices.size());
+  if (!simple)
+    ImGui::TextWrapped("Warning: the polygon crosses itself and won't be "
+        "triangulated");
   if (ImGui::Button("Triangulate")) {
-    triangulate(method);
+    triangulate_options options(method);
+    options.check_simple = true;
+    triangulation_result.resize(3 * max_triangles(mainpoly.vertices.size()));
+    triangulation_result.resize(3 * triangulate(mainpoly.vertices.data()
+          , mainpoly.vertices.size(), options, triangulation_result.data()));
     draw_tri = true;
   }
   ImGui::End();
@@ -441,10 +322,11 @@ void draw(double alpha) {
   };
 
   if (draw_tri) // draw triangulated polygon
-    for (size_t i = 0; i < triangulation_result.triangles.size(); i++) {
-      const polygon &triangle = triangulation_result.triangles[i];
-      const vertex &v1 = triangle.vertices[0], &v2 = triangle.vertices[1]
-        , &v3 = triangle.vertices[2];
+    for (size_t i = 0; i < triangulation_result.size() / 3; i++) {
+      const uint32_t *triangle = &triangulation_result[3 * i];
+      const vertex &v1 = mainpoly.vertices[triangle[0]]
+        , &v2 = mainpoly.vertices[triangle[1]]
+        , &v3 = mainpoly.vertices[triangle[2]];
       const std::vector<float> tri_verts = { v1.x, v1.y, v2.x, v2.y, v3.x, v3.y };
       array_buffer tri_buf;
       tri_buf.bind();
@@ -454,7 +336,8 @@ void draw(double alpha) {
 
       glm::mat4 id_model;
       glUniformMatrix4fv(modelmat_unif, 1, GL_FALSE, glm::value_ptr(id_model));
-      auto color = hue_to_rgb((float)i / (float)triangulation_result.triangles.size());
+      auto color = hue_to_rgb((float)i
+          / (float)(triangulation_result.size() / 3));
       glUniform3f(color_unif, color.r, color.g, color.b);
       glDrawArrays(GL_TRIANGLES, 0, 3);
       tri_buf.unbind();
@@ -0,0 +1,382 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <set>
+
+// the polygon has to wind counter-clockwise (with y pointing up), and its holes
+// clockwise, so that its interior is on the left of every edge. holes need no
+// special treatment: the top vertex of every hole is a split vertex, and the
+// diagonal drawn up from it ties the hole to the rest of the polygon
+
+enum vertex_kind
+{
+  start_vertex,
+  end_vertex,
+  split_vertex,
+  merge_vertex,
+  regular_vertex
+};
+
+template <typename T>
+struct sweep_state
+{
+  const vec2<T> *vertices;
+  const uint32_t *next;
+  uint32_t inserted, current;
+};
+
+// orders the edges cut by the sweep line from left to right. std::set only
+// ever compares the edge being inserted (or the lookup key) against edges
+// that are already in it, so all it takes is to know on which side of an edge
+// the current vertex lies
+template <typename T>
+struct edge_order
+{
+  const sweep_state<T> *state;
+
+  bool operator()(uint32_t a, uint32_t b) const {
+    if (a == state->inserted)
+      return !right_of(b);
+    return right_of(a);
+  }
+  bool right_of(uint32_t e) const {
+    const vec2<T> &upper = state->vertices[e]
+      , &lower = state->vertices[state->next[e]];
+    return orient(upper, lower, state->vertices[state->current]) > 0;
+  }
+};
+
+// splits the polygon into y-monotone pieces with a downward sweep, inserting
+// a diagonal at every split and merge vertex
+template <typename T>
+static void make_monotone(const vec2<T> *vertices, const polygon_rings &rings
+    , std::vector<diagonal> *diagonals) {
+  size_t n = rings.n;
+  std::vector<uint8_t> kind(n);
+  std::vector<uint32_t> order(n);
+  for (size_t i = 0; i < n; i++) {
+    const vec2<T> &p = vertices[rings.prev[i]], &c = vertices[i]
+      , &nx = vertices[rings.next[i]];
+    bool prev_below = above(c, p), next_below = above(c, nx)
+      , convex = orient(p, c, nx) >= 0;
+    if (prev_below && next_below)
+      kind[i] = convex ? start_vertex : split_vertex;
+    else if (!prev_below && !next_below)
+      kind[i] = convex ? end_vertex : merge_vertex;
+    else
+      kind[i] = regular_vertex;
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [vertices](uint32_t a, uint32_t b) {
+        return above(vertices[a], vertices[b]);
+      });
+
+  sweep_state<T> state = { vertices, rings.next.data(), (uint32_t)n, 0 };
+  typedef std::set<uint32_t, edge_order<T>> edge_set;
+  edge_set status(edge_order<T> { &state });
+  std::vector<typename edge_set::iterator> where(n);
+  std::vector<uint8_t> in_status(n, 0);
+  std::vector<uint32_t> helper(n);
+
+  auto insert = [&](uint32_t e) {
+    state.inserted = e;
+    where[e] = status.insert(e).first;
+    state.inserted = n;
+    in_status[e] = 1;
+    helper[e] = e;
+  };
+  auto connect_merge_helper = [&](uint32_t v, uint32_t e) {
+    if (kind[helper[e]] == merge_vertex)
+      diagonals->push_back({ v, helper[e] });
+  };
+  auto remove = [&](uint32_t v, uint32_t e) {
+    if (!in_status[e])
+      return;
+    connect_merge_helper(v, e);
+    status.erase(where[e]);
+    in_status[e] = 0;
+  };
+  // edge directly to the left of the current vertex, or n if there's none,
+  // which happens only on input that isn't a simple ccw polygon
+  auto left_edge = [&]() -> uint32_t {
+    typename edge_set::iterator it = status.lower_bound((uint32_t)n);
+    if (it == status.begin())
+      return n;
+    return *--it;
+  };
+
+  for (uint32_t v : order) {
+    uint32_t prev = rings.prev[v], left;
+    state.current = v;
+    switch (kind[v]) {
+      case start_vertex:
+        insert(v);
+        break;
+      case end_vertex:
+        remove(v, prev);
+        break;
+      case split_vertex:
+        if ((left = left_edge()) != n) {
+          diagonals->push_back({ v, helper[left] });
+          helper[left] = v;
+        }
+        insert(v);
+        break;
+      case merge_vertex:
+        remove(v, prev);
+        if ((left = left_edge()) != n) {
+          connect_merge_helper(v, left);
+          helper[left] = v;
+        }
+        break;
+      default:
+        if (above(vertices[prev], vertices[v])) { // interior to the right
+          remove(v, prev);
+          insert(v);
+        } else if ((left = left_edge()) != n) {
+          connect_merge_helper(v, left);
+          helper[left] = v;
+        }
+    }
+  }
+}
+
+// triangulates a single y-monotone ccw polygon in linear time by walking its
+// two chains from the top and keeping the not yet triangulated vertices on a
+// stack
+template <typename T>
+static void triangulate_piece(const vec2<T> *vertices, const uint32_t *piece
+    , size_t m, index_sink *out, std::vector<uint32_t> &sorted
+    , std::vector<uint8_t> &left, std::vector<uint32_t> &stack) {
+  if (m == 3) {
+    out->emit(piece[0], piece[1], piece[2]);
+    return;
+  }
+  size_t top = 0, bottom = 0;
+  for (size_t k = 1; k < m; k++) {
+    if (above(vertices[piece[k]], vertices[piece[top]]))
+      top = k;
+    if (above(vertices[piece[bottom]], vertices[piece[k]]))
+      bottom = k;
+  }
+  // merge the two chains into sweep order. going ccw from the top vertex
+  // leads down the left chain
+  sorted.clear();
+  left.clear();
+  sorted.push_back(piece[top]);
+  left.push_back(1);
+  size_t l = top + 1 == m ? 0 : top + 1, r = top == 0 ? m - 1 : top - 1;
+  while (l != bottom || r != bottom)
+    if (r == bottom || (l != bottom
+          && above(vertices[piece[l]], vertices[piece[r]]))) {
+      sorted.push_back(piece[l]);
+      left.push_back(1);
+      l = l + 1 == m ? 0 : l + 1;
+    } else {
+      sorted.push_back(piece[r]);
+      left.push_back(0);
+      r = r == 0 ? m - 1 : r - 1;
+    }
+  sorted.push_back(piece[bottom]);
+  left.push_back(1);
+
+  // emits the fan from u to the vertices on the stack, which lie on the
+  // chain opposite to u
+  auto fan = [&](size_t j, bool u_left) {
+    for (size_t k = 0; k + 1 < stack.size(); k++) {
+      uint32_t u = sorted[j], a = sorted[stack[k]], b = sorted[stack[k + 1]];
+      if (u_left)
+        out->emit(u, b, a);
+      else
+        out->emit(u, a, b);
+    }
+  };
+  stack.clear();
+  stack.push_back(0);
+  stack.push_back(1);
+  for (size_t j = 2; j + 1 < m; j++) {
+    uint32_t u = sorted[j];
+    if (left[j] != left[stack.back()]) {
+      fan(j, left[j]);
+      stack.clear();
+      stack.push_back(j - 1);
+      stack.push_back(j);
+    } else {
+      size_t last = stack.back();
+      stack.pop_back();
+      while (!stack.empty()) {
+        const vec2<T> &vt = vertices[sorted[stack.back()]]
+          , &vl = vertices[sorted[last]], &vu = vertices[u];
+        if (left[j]) {
+          if (orient(vt, vl, vu) <= 0)
+            break;
+          out->emit(sorted[stack.back()], sorted[last], u);
+        } else {
+          if (orient(vu, vl, vt) <= 0)
+            break;
+          out->emit(u, sorted[last], sorted[stack.back()]);
+        }
+        last = stack.back();
+        stack.pop_back();
+      }
+      stack.push_back(last);
+      stack.push_back(j);
+    }
+  }
+  fan(m - 1, !left[stack.back()]);
+}
+
+// outgoing edges of a vertex in ccw order, starting from the positive x axis
+template <typename T>
+struct angle_order
+{
+  const vec2<T> *vertices;
+  const uint32_t *dest;
+  vec2<T> origin;
+
+  bool operator()(uint32_t a, uint32_t b) const {
+    const vec2<T> &pa = vertices[dest[a]], &pb = vertices[dest[b]];
+    bool a_lower = pa.y < origin.y || (pa.y == origin.y && pa.x < origin.x)
+      , b_lower = pb.y < origin.y || (pb.y == origin.y && pb.x < origin.x);
+    if (a_lower != b_lower)
+      return b_lower;
+    return orient(origin, pa, pb) > 0;
+  }
+};
+
+// calls `face` with the vertices of every face that the diagonals cut the
+// polygon into, in ccw order
+template <typename T, typename F>
+static void trace_faces(const vec2<T> *vertices, const polygon_rings &rings
+    , const std::vector<diagonal> &diagonals, F face) {
+  // half-edges: [0, n) are the polygon edges, [n, 2n) their twins running
+  // along the outside, and after that come both directions of every diagonal
+  size_t n = rings.n, hn = 2 * n + 2 * diagonals.size();
+  std::vector<uint32_t> origin(hn), dest(hn), piece;
+  for (size_t i = 0; i < n; i++) {
+    origin[i] = dest[n + i] = i;
+    dest[i] = origin[n + i] = rings.next[i];
+  }
+  for (size_t k = 0; k < diagonals.size(); k++) {
+    origin[2 * n + 2 * k] = dest[2 * n + 2 * k + 1] = diagonals[k].a;
+    dest[2 * n + 2 * k] = origin[2 * n + 2 * k + 1] = diagonals[k].b;
+  }
+  auto twin = [n](size_t h) -> size_t {
+    if (h < n)
+      return h + n;
+    if (h < 2 * n)
+      return h - n;
+    return h ^ 1;
+  };
+
+  // group the half-edges by origin and sort each group around its vertex
+  std::vector<uint32_t> first(n + 1, 0), rotation(hn), position(hn);
+  for (size_t h = 0; h < hn; h++)
+    first[origin[h] + 1]++;
+  for (size_t i = 0; i < n; i++)
+    first[i + 1] += first[i];
+  std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+  for (size_t h = 0; h < hn; h++)
+    rotation[fill[origin[h]]++] = h;
+  for (size_t i = 0; i < n; i++) {
+    if (first[i + 1] - first[i] > 2)
+      std::sort(rotation.begin() + first[i], rotation.begin() + first[i + 1]
+          , angle_order<T> { vertices, dest.data(), vertices[i] });
+    for (size_t k = first[i]; k < first[i + 1]; k++)
+      position[rotation[k]] = k;
+  }
+
+  // walk every face to the left of a not yet visited inner half-edge. the
+  // edge after u->w is the one leaving w just clockwise of w->u
+  std::vector<uint8_t> visited(hn, 0);
+  for (size_t h = n; h < 2 * n; h++)
+    visited[h] = 1;
+  for (size_t h0 = 0; h0 < hn; h0++) {
+    if (visited[h0])
+      continue;
+    piece.clear();
+    size_t h = h0;
+    do {
+      visited[h] = 1;
+      piece.push_back(origin[h]);
+      uint32_t w = dest[h], k = position[twin(h)];
+      h = rotation[k == first[w] ? first[w + 1] - 1 : k - 1];
+    } while (h != h0 && piece.size() <= hn);
+    if (piece.size() >= 3)
+      face(piece);
+  }
+}
+
+template <typename T>
+void triangulate_monotone_pieces(const vec2<T> *vertices
+    , const polygon_rings &rings, const std::vector<diagonal> &diagonals
+    , index_sink *out) {
+  std::vector<uint32_t> sorted, stack;
+  std::vector<uint8_t> left;
+  if (diagonals.empty() && rings.holes.empty()) {
+    std::vector<uint32_t> piece(rings.n);
+    for (size_t i = 0, v = 0; i < rings.n; i++, v = rings.next[v])
+      piece[i] = v;
+    triangulate_piece(vertices, piece.data(), rings.n, out, sorted, left
+        , stack);
+    return;
+  }
+  trace_faces(vertices, rings, diagonals
+      , [&](const std::vector<uint32_t> &piece) {
+        triangulate_piece(vertices, piece.data(), piece.size(), out, sorted
+            , left, stack);
+      });
+}
+
+template <typename T>
+void monotone_triangulate(const vec2<T> *vertices, const polygon_rings &rings
+    , index_sink *out) {
+  std::vector<diagonal> diagonals;
+  make_monotone(vertices, rings, &diagonals);
+  triangulate_monotone_pieces(vertices, rings, diagonals, out);
+}
+
+// joins every hole to the outer ring with a bridge, and returns the boundary
+// of the result as a single ring that passes through both ends of every
+// bridge twice. the bridges are the diagonals make_monotone() draws up from
+// the top vertices of the holes: they cross neither each other nor the
+// boundary, and each one leads to a vertex higher up, so that following them
+// always ends at the outer ring. one sweep finds all of them, where casting a
+// ray from every hole would take a pass over the polygon per hole
+template <typename T>
+void bridge_holes(const vec2<T> *vertices, const polygon_rings &rings
+    , std::vector<uint32_t> *ring) {
+  std::vector<uint8_t> top(rings.n, 0);
+  for (uint32_t start : rings.holes) {
+    uint32_t highest = start;
+    for (uint32_t v = rings.next[start]; v != start; v = rings.next[v])
+      if (above(vertices[v], vertices[highest]))
+        highest = v;
+    top[highest] = 1;
+  }
+  std::vector<diagonal> diagonals, bridges;
+  make_monotone(vertices, rings, &diagonals);
+  for (const diagonal &d : diagonals)
+    if (top[d.a])
+      bridges.push_back(d);
+  // the face with the first edge of the outer ring is all there is, unless
+  // the holes stick out of the polygon
+  ring->clear();
+  trace_faces(vertices, rings, bridges
+      , [ring](const std::vector<uint32_t> &piece) {
+        if (ring->empty())
+          *ring = piece;
+      });
+}
+
+#define INSTANTIATE(T) \
+  template void triangulate_monotone_pieces(const vec2<T> *vertices \
+      , const polygon_rings &rings, const std::vector<diagonal> &diagonals \
+      , index_sink *out); \
+  template void monotone_triangulate(const vec2<T> *vertices \
+      , const polygon_rings &rings, index_sink *out); \
+  template void bridge_holes(const vec2<T> *vertices \
+      , const polygon_rings &rings, std::vector<uint32_t> *ring);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
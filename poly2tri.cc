@@ -0,0 +1,371 @@
+#include "poly2tri.hh"
+#include "triangulators.hh"
+#include "simd.hh"
+
+// strictly convex and ccw, or cw if `reversed`: every turn is to the same
+// side and the edges go around exactly once, which rules out stars that wind
+// around their center several times. an edge "wraps" when its direction
+// crosses from the upper half-plane into the lower one, which it does once
+// either way round
+template <typename T>
+bool is_convex(const vec2<T> *vertices, size_t n, bool reversed) {
+  auto lower = [vertices, n](size_t i) {
+    const vec2<T> &a = vertices[i], &b = vertices[i + 1 == n ? 0 : i + 1];
+    return b.y < a.y || (b.y == a.y && b.x < a.x);
+  };
+  size_t wraps = 0;
+  bool was_lower = lower(n - 1);
+  for (size_t i = 0; i < n; i++) {
+    auto turn = orient(vertices[i == 0 ? n - 1 : i - 1], vertices[i]
+        , vertices[i + 1 == n ? 0 : i + 1]);
+    if (reversed ? turn >= 0 : turn <= 0)
+      return false;
+    bool is_lower = lower(i);
+    wraps += is_lower && !was_lower;
+    was_lower = is_lower;
+  }
+  return wraps == 1;
+}
+
+void fan_triangulate(size_t n, index_sink *out, bool reversed) {
+  for (size_t i = 1; i + 1 < n; i++)
+    if (reversed)
+      out->emit(0, i + 1, i);
+    else
+      out->emit(0, i, i + 1);
+  if (out->neighbors)
+    for (int32_t t = 0; t < (int32_t)out->count; t++) {
+      int32_t before = t - 1, after = t + 2 < (int32_t)n - 1 ? t + 1 : -1;
+      out->link(t, 0, reversed ? after : before);
+      out->link(t, 1, -1);
+      out->link(t, 2, reversed ? before : after);
+    }
+}
+
+// a convex polygon cut across its longer side, the vertices of the two
+// chains between its ends taken in order along it. a fan is as far from
+// delaunay as a triangulation gets, quadratically many flips away on a long
+// ellipse, where this has the short edges delaunay has
+template <typename T>
+static void zigzag_triangulate(const vec2<T> *vertices, size_t n
+    , index_sink *out, bool reversed) {
+  auto at = [vertices, n, reversed](size_t i) -> const vec2<T> & {
+    return vertices[reversed ? (n - i) % n : i];
+  };
+  auto index = [n, reversed](size_t i) {
+    return (uint32_t)(reversed ? (n - i) % n : i);
+  };
+  T min_x = at(0).x, max_x = at(0).x, min_y = at(0).y, max_y = at(0).y;
+  for (size_t i = 1; i < n; i++) {
+    min_x = std::min(min_x, at(i).x), max_x = std::max(max_x, at(i).x);
+    min_y = std::min(min_y, at(i).y), max_y = std::max(max_y, at(i).y);
+  }
+  bool along_x = (double)max_x - (double)min_x
+    >= (double)max_y - (double)min_y;
+  auto key = [&](size_t i) {
+    return along_x ? at(i).x : at(i).y;
+  };
+  size_t first = 0;
+  for (size_t i = 1; i < n; i++)
+    if (key(i) < key(first))
+      first = i;
+  // the two chains grow from `first`, a ccw and b cw, the next vertex along
+  // being added to the one it's nearer the front of
+  size_t a = (first + 1) % n, b = (first + n - 1) % n;
+  out->emit(index(b), index(first), index(a));
+  for (size_t left = n - 3; left > 0; left--) {
+    size_t after_a = (a + 1) % n, before_b = (b + n - 1) % n;
+    if (key(after_a) <= key(before_b)) {
+      out->emit(index(a), index(after_a), index(b));
+      a = after_a;
+    } else {
+      out->emit(index(before_b), index(b), index(a));
+      b = before_b;
+    }
+  }
+}
+
+// twice the signed area of the ring, summed up relative to its first vertex
+// to keep the products small. avx2 takes two edges a step, each one's cross
+// product landing as a pair of lanes
+template <typename T>
+static double twice_area(const vec2<T> *vertices, size_t n, size_t first) {
+  double x0 = (double)vertices[0].x, y0 = (double)vertices[0].y, area = 0;
+  for (size_t i = first; i < n; i++) {
+    const vec2<T> &a = vertices[i], &b = vertices[i + 1 == n ? 0 : i + 1];
+    area += ((double)a.x - x0) * ((double)b.y - y0)
+      - ((double)a.y - y0) * ((double)b.x - x0);
+  }
+  return area;
+}
+
+#ifdef SIMD_X86
+// two vertices as x, y, x, y
+TARGET_AVX2
+static inline __m256d load_pair(const vec2<double> *v) {
+  return _mm256_loadu_pd(&v->x);
+}
+
+TARGET_AVX2
+static inline __m256d load_pair(const vec2<float> *v) {
+  return _mm256_cvtps_pd(_mm_loadu_ps(&v->x));
+}
+
+TARGET_AVX2
+static inline __m256d load_pair(const vec2<int32_t> *v) {
+  return _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)&v->x));
+}
+
+template <typename T>
+TARGET_AVX2
+static double twice_area_avx2(const vec2<T> *vertices, size_t n) {
+  const __m256d origin = _mm256_setr_pd(vertices[0].x, vertices[0].y
+      , vertices[0].x, vertices[0].y);
+  __m256d sum = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 3 <= n; i += 2) {
+    __m256d a = _mm256_sub_pd(load_pair(vertices + i), origin)
+      , b = _mm256_sub_pd(load_pair(vertices + i + 1), origin);
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(a, _mm256_permute_pd(b, 5)));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, sum);
+  return lanes[0] - lanes[1] + lanes[2] - lanes[3]
+    + twice_area(vertices, n, i);
+}
+#endif
+
+template <typename T>
+double signed_area(const vec2<T> *vertices, size_t n) {
+  if (n < 3)
+    return 0;
+#ifdef SIMD_X86
+  static const bool avx2 = cpu_has_avx2();
+  if (avx2)
+    return twice_area_avx2(vertices, n) / 2;
+#endif
+  return twice_area(vertices, n, 0) / 2;
+}
+
+polygon_rings::polygon_rings(size_t n_vertices, const uint32_t *hole_starts
+    , size_t hole_count, bool n_reversed)
+  : n(n_vertices), reversed(n_reversed), next(n_vertices), prev(n_vertices)
+  , holes(hole_starts, hole_starts + hole_count) {
+  for (size_t k = 0; k <= hole_count; k++) {
+    size_t first = k == 0 ? 0 : hole_starts[k - 1]
+      , end = k == hole_count ? n : hole_starts[k];
+    for (size_t i = first; i < end; i++) {
+      next[i] = i + 1 == end ? first : i + 1;
+      prev[i] = i == first ? end - 1 : i - 1;
+    }
+  }
+  if (reversed)
+    next.swap(prev);
+}
+
+// triangulates what simplify() leaves of the polygon, and points the
+// indices back at the vertices it was given
+template <typename T>
+static size_t triangulate_simplified(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, index_sink *out) {
+  std::vector<uint32_t> kept, kept_hole_starts;
+  simplify(vertices, n, hole_starts, holes, options.simplify_tolerance, &kept
+      , &kept_hole_starts);
+  std::vector<vec2<T>> fewer(kept.size());
+  for (size_t i = 0; i < kept.size(); i++)
+    fewer[i] = vertices[kept[i]];
+  size_t triangles = max_triangles(kept.size(), kept_hole_starts.size());
+  std::vector<uint32_t> indices(3 * triangles);
+  std::vector<int32_t> neighbors(out->neighbors ? indices.size() : 0);
+  index_sink sink(indices.data(), nullptr, triangles
+      , out->neighbors ? neighbors.data() : nullptr);
+  triangulate_options inner(options);
+  inner.simplify = false;
+  triangulate_polygon(fewer.data(), fewer.size(), kept_hole_starts.data()
+      , kept_hole_starts.size(), inner, &sink);
+  for (size_t i = 0; i < 3 * sink.count; i += 3)
+    out->emit(kept[indices[i]], kept[indices[i + 1]], kept[indices[i + 2]]);
+  if (out->neighbors)
+    std::copy(neighbors.begin(), neighbors.begin() + 3 * out->count
+        , out->neighbors);
+  return out->count;
+}
+
+template <typename T>
+size_t triangulate_polygon(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, index_sink *out) {
+  if (n < 3)
+    return 0;
+  if (options.simplify)
+    return triangulate_simplified(vertices, n, hole_starts, holes, options
+        , out);
+  if (options.check_simple && !is_simple(vertices, n, hole_starts, holes))
+    return 0;
+  // Auto measures everything it goes by in one pass, which has the area
+  // and convexity in it too
+  int method = options.method;
+  double area;
+  bool convex = false;
+  if (method == Auto) {
+    polygon_stats stats = measure_polygon(vertices, n, hole_starts, holes);
+    method = choose_method(stats, options.thresholds);
+    area = stats.area;
+    convex = stats.convex;
+  } else
+    area = signed_area(vertices, holes == 0 ? n : hole_starts[0]);
+  // a ring that winds cw is taken the other way around, holes and all,
+  // which leaves the vertices where they are and the triangles ccw
+  if (options.winding)
+    *options.winding = area > 0 ? 1 : area < 0 ? -1 : 0;
+  bool reversed = area < 0;
+  // a fan is all a convex polygon needs, whatever the method
+  if (options.method != Auto)
+    convex = holes == 0 && method != StackBased
+      && method != ConstrainedDelaunay && is_convex(vertices, n, reversed);
+  polygon_rings rings(n, hole_starts, holes, reversed);
+  // the monotone pieces and the bridged ring don't keep track of which
+  // triangle is next to which, so their neighbours are worked out after
+  bool linked = true;
+  if (convex && options.delaunay_flips)
+    zigzag_triangulate(vertices, n, out, reversed);
+  else if ((method == StackBased && holes == 0)
+      || (convex && method != ConstrainedDelaunay))
+    fan_triangulate(n, out, reversed);
+  else if (method == MonotoneSweep) {
+    monotone_triangulate(vertices, rings, out);
+    linked = false;
+  } else if (method == Trapezoidation) {
+    seidel_triangulate(vertices, rings, out);
+    linked = false;
+  } else if (method == ConstrainedDelaunay)
+    cdt_triangulate(vertices, rings, out);
+  else if (holes == 0 && !reversed)
+    earclip_triangulate(vertices, nullptr, n, options.zorder_index, out);
+  else if (holes == 0) {
+    std::vector<uint32_t> order(n);
+    for (size_t i = 0; i < n; i++)
+      order[i] = (n - i) % n;
+    earclip_triangulate(vertices, order.data(), n, options.zorder_index, out);
+  } else {
+    std::vector<uint32_t> ring;
+    bridge_holes(vertices, rings, &ring);
+    earclip_triangulate(vertices, ring.data(), ring.size()
+        , options.zorder_index, out);
+    linked = false;
+  }
+  // the flips pair up the edges themselves, so they need no neighbours from
+  // the method
+  if (options.delaunay_flips && method != ConstrainedDelaunay)
+    delaunay_flip(vertices, n, out);
+  else if (!linked && out->neighbors)
+    link_output(n, out);
+  return out->count;
+}
+
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const triangulate_options &options, uint32_t *indices
+    , int32_t *neighbors) {
+  index_sink out(indices, nullptr, max_triangles(n), neighbors);
+  return triangulate_polygon(vertices, n, nullptr, 0, options, &out);
+}
+
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const triangulate_options &options, uint16_t *indices
+    , int32_t *neighbors) {
+  // the indices would be cut down to 16 bits and point somewhere else
+  if (n > UINT16_MAX)
+    return 0;
+  index_sink out(nullptr, indices, max_triangles(n), neighbors);
+  return triangulate_polygon(vertices, n, nullptr, 0, options, &out);
+}
+
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, uint32_t *indices
+    , int32_t *neighbors) {
+  index_sink out(indices, nullptr, max_triangles(n, holes), neighbors);
+  return triangulate_polygon(vertices, n, hole_starts, holes, options
+      , &out);
+}
+
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, uint16_t *indices
+    , int32_t *neighbors) {
+  if (n > UINT16_MAX)
+    return 0;
+  index_sink out(nullptr, indices, max_triangles(n, holes), neighbors);
+  return triangulate_polygon(vertices, n, hole_starts, holes, options
+      , &out);
+}
+
+#define INSTANTIATE(T) \
+  template bool is_convex(const vec2<T> *vertices, size_t n \
+      , bool reversed); \
+  template double signed_area(const vec2<T> *vertices, size_t n); \
+  template size_t triangulate_polygon(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes \
+      , const triangulate_options &options, index_sink *out); \
+  template size_t triangulate(const vec2<T> *vertices, size_t n \
+      , const triangulate_options &options, uint32_t *indices \
+      , int32_t *neighbors); \
+  template size_t triangulate(const vec2<T> *vertices, size_t n \
+      , const triangulate_options &options, uint16_t *indices \
+      , int32_t *neighbors); \
+  template size_t triangulate(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes \
+      , const triangulate_options &options, uint32_t *indices \
+      , int32_t *neighbors); \
+  template size_t triangulate(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes \
+      , const triangulate_options &options, uint16_t *indices \
+      , int32_t *neighbors);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
+
+void triangulate(const vertex *vertices, size_t n
+    , const triangulate_options &options, triangule_soup *out) {
+  std::vector<uint32_t> indices(3 * max_triangles(n));
+  out->neighbors.resize(indices.size());
+  size_t count = triangulate(vertices, n, options, indices.data()
+      , out->neighbors.data());
+  out->neighbors.resize(3 * count);
+  out->triangles.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    const uint32_t *t = &indices[3 * i];
+    out->triangles[i].vertices = { vertices[t[0]], vertices[t[1]]
+      , vertices[t[2]] };
+  }
+}
+
+void triangulate(const polygon &poly, const triangulate_options &options
+    , triangule_soup *out) {
+  std::vector<vertex> vertices(poly.vertices);
+  std::vector<uint32_t> hole_starts;
+  for (const std::vector<vertex> &hole : poly.holes) {
+    hole_starts.push_back(vertices.size());
+    vertices.insert(vertices.end(), hole.begin(), hole.end());
+  }
+  std::vector<uint32_t> indices(3 * max_triangles(vertices.size()
+        , hole_starts.size()));
+  out->neighbors.resize(indices.size());
+  size_t count = triangulate(vertices.data(), vertices.size()
+      , hole_starts.data(), hole_starts.size(), options, indices.data()
+      , out->neighbors.data());
+  out->neighbors.resize(3 * count);
+  out->triangles.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    const uint32_t *t = &indices[3 * i];
+    out->triangles[i].vertices = { vertices[t[0]], vertices[t[1]]
+      , vertices[t[2]] };
+  }
+}
+
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+
+enum method
+{
+  StackBased = 0,
+  MonotoneSweep = 1,
+  EarClipping = 2,
+  ConstrainedDelaunay = 3,
+  Trapezoidation = 4,
+  // picks one of the above from measure_polygon(), see choose_method()
+  Auto = 5
+};
+
+// the functions below that take a vec2<T> are built for float, double and
+// int32_t coordinates. the geometric tests they make are exact for any
+// floating point input, and for integer input as long as it stays within
+// +-2^30, so that degenerate and nearly degenerate polygons come out the same
+// way every time
+template <typename T>
+struct vec2
+{
+  T x, y;
+};
+typedef vec2<float> vertex;
+
+struct polygon
+{
+  std::vector<vertex> vertices;
+  // rings cut out of the polygon, winding the other way
+  std::vector<std::vector<vertex>> holes;
+};
+
+struct triangule_soup
+{
+  std::vector<polygon> triangles;
+  // the three triangles next to every triangle, across its edges from the
+  // first vertex to the second, the second to the third and the third to the
+  // first. -1 where an edge is on the boundary
+  std::vector<int32_t> neighbors;
+};
+
+// number of triangles a polygon with `n` vertices is cut into. index buffers
+// handed to triangulate() need room for three times as many elements
+inline size_t max_triangles(size_t n) {
+  return n < 3 ? 0 : n - 2;
+}
+
+// same for a polygon with holes, `n` being the number of vertices of all of
+// its rings together
+inline size_t max_triangles(size_t n, size_t holes) {
+  return n < 3 ? 0 : n + 2 * holes - 2;
+}
+
+// what Auto goes by. the defaults are where the methods crossed over on the
+// machine the library was tuned on, calibrate_dispatch() measures them anew
+struct dispatch_thresholds
+{
+  // the ear clipper beats the monotone sweep on polygons without holes of up
+  // to this many vertices
+  size_t earclip_vertices;
+  // as long as no more of them than this are reflex
+  size_t earclip_reflex;
+  // and their bounding box is no more than this many times as long as it's
+  // wide
+  double earclip_aspect;
+
+  dispatch_thresholds()
+    : earclip_vertices(24), earclip_reflex(6), earclip_aspect(HUGE_VAL) {}
+};
+
+// everything triangulate() can be asked to do besides the plain method.
+// converts implicitly from a method
+struct triangulate_options
+{
+  int method;
+  // ear clipping: finds the vertices that could block an ear through a
+  // z-order curve over the bounding box instead of testing every reflex
+  // vertex. pays off from a few hundred vertices up
+  bool zorder_index;
+  // flips every inner edge of the result that isn't locally delaunay, with
+  // lawson's algorithm, until it's the constrained delaunay triangulation.
+  // takes out the slivers the ear clipper and the others leave, for a pass
+  // over the triangles and a few flips a vertex on typical input, much less
+  // than ConstrainedDelaunay takes. a convex polygon starts from a zigzag
+  // along its longer side rather than a fan, which could take quadratically
+  // many flips
+  bool delaunay_flips;
+  // runs the polygon through simplify() first, with `simplify_tolerance`,
+  // and triangulates what's left. the indices still point into the vertices
+  // that were passed in, and there are fewer triangles for every vertex
+  // taken out
+  bool simplify;
+  double simplify_tolerance;
+  // checks the polygon with is_simple() first and writes no triangles at all
+  // if it isn't, rather than whatever the method makes of it. costs about as
+  // much as the monotone sweep
+  bool check_simple;
+  // if given, gets 1 when the outer ring winds ccw, -1 when it winds cw and
+  // 0 when it has no area
+  int *winding;
+  // where Auto switches methods
+  dispatch_thresholds thresholds;
+
+  triangulate_options(int n_method = EarClipping)
+    : method(n_method), zorder_index(false), delaunay_flips(false)
+    , simplify(false), simplify_tolerance(0), check_simple(false)
+    , winding(nullptr) {}
+};
+
+// what Auto looks at, all gathered in one pass over the vertices
+struct polygon_stats
+{
+  size_t n, holes;
+  // vertices whose inner angle is over 180 degrees, on holes too
+  size_t reflex;
+  // strictly convex, with no holes
+  bool convex;
+  // longer side of the bounding box over the shorter one
+  double aspect;
+  // signed area of the outer ring, as signed_area() has it
+  double area;
+};
+
+// the statistics of a polygon laid out as for triangulate()
+template <typename T>
+polygon_stats measure_polygon(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts = nullptr, size_t holes = 0);
+
+// the method Auto takes for a polygon with `stats`: a fan for convex ones,
+// the ear clipper for small ones within `thresholds`, and the monotone sweep
+// for the rest, holes, long noisy outlines and all. the trapezoidation is
+// never faster, and ConstrainedDelaunay is left to be asked for
+int choose_method(const polygon_stats &stats
+    , const dispatch_thresholds &thresholds);
+
+// times the ear clipper against the monotone sweep on generated polygons of
+// growing size, reflex count and aspect, and returns the points where it
+// stops being faster. takes a few seconds
+dispatch_thresholds calibrate_dispatch();
+
+// area of the ring of `n` vertices, positive when it winds ccw and negative
+// when it winds cw. summed up in double, with avx2 where the cpu has it
+template <typename T>
+double signed_area(const vec2<T> *vertices, size_t n);
+
+// triangulates the polygon made of `n` vertices starting at `vertices` and
+// writes every triangle as three indices into `vertices` to `indices`.
+// returns the number of triangles written. the polygon may wind either way,
+// and the triangles always come out ccw. strictly convex polygons are
+// detected on the way and fanned out directly by every method but the
+// delaunay one. everything it touches comes in through the arguments, so any
+// number of these can run at once on different threads. `neighbors`, if
+// given, gets the three neighbours of every triangle as laid out in
+// triangule_soup, with as much room as `indices`. the fan, the ear clipper
+// and the delaunay triangulation keep track of them as they go, the monotone
+// pieces and polygons with holes clipped as one ring have them sorted out in
+// a linear pass at the end
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const triangulate_options &options, uint32_t *indices
+    , int32_t *neighbors = nullptr);
+
+// same, but with 16-bit indices for polygons of less than 65536 vertices.
+// writes nothing and returns 0 for larger ones
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const triangulate_options &options, uint16_t *indices
+    , int32_t *neighbors = nullptr);
+
+// same, but copies the vertices of every triangle to `out`
+void triangulate(const vertex *vertices, size_t n
+    , const triangulate_options &options, triangule_soup *out);
+
+// triangulates a polygon with holes. `vertices` holds the outer ring, winding
+// ccw, followed by every hole, winding cw and at least three vertices long.
+// all of them may wind the other way instead, going by the outer ring.
+// hole k starts at hole_starts[k]. the ear clipper bridges the holes to the
+// outer ring first and clips the result as a single ring (and so does
+// StackBased, as a fan can't go around holes), the monotone, delaunay and
+// trapezoidation methods take them as they are
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, uint32_t *indices
+    , int32_t *neighbors = nullptr);
+
+// same, with 16-bit indices and the same limit
+template <typename T>
+size_t triangulate(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, uint16_t *indices
+    , int32_t *neighbors = nullptr);
+
+// same, for a polygon with its holes stored separately
+void triangulate(const polygon &poly, const triangulate_options &options
+    , triangule_soup *out);
+
+// cleans up a polygon laid out as for triangulate() ahead of triangulating
+// it. vertices that coincide with the next one around their ring or lie on a
+// straight line between their neighbours always go, which leaves the polygon
+// as it was. with a `tolerance` above 0 the rings are then simplified with
+// douglas-peucker, dropping vertices that stay within `tolerance` of the
+// edges that replace them, but never so that a ring would cross itself or
+// another ring. `kept` gets the original indices of the vertices left, ring
+// by ring in their original order, and `kept_hole_starts` where every hole
+// starts in it. holes that were no more than a line are left out. returns the
+// number of vertices left, 0 if the outer ring was no more than a line
+template <typename T>
+size_t simplify(const vec2<T> *vertices, size_t n, const uint32_t *hole_starts
+    , size_t holes, double tolerance, std::vector<uint32_t> *kept
+    , std::vector<uint32_t> *kept_hole_starts = nullptr);
+
+// a point where two edges of a polygon meet that shouldn't, edge i running
+// from vertex i to the next one around its ring. either they cross there, or
+// one of them ends on the other or they overlap, and `point` is a vertex
+struct edge_crossing
+{
+  uint32_t first, second;
+  vec2<double> point;
+};
+
+// finds every point where the edges of a polygon laid out as for
+// triangulate() cross or touch, each pair of edges once, with a
+// bentley-ottmann sweep in O((n + k) log n) for k of them. stops at the first
+// one with `first_only`. returns how many there are
+template <typename T>
+size_t find_crossings(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , std::vector<edge_crossing> *crossings, bool first_only = false);
+
+// whether no two edges of the polygon meet other than where one follows the
+// other, which is what every method of triangulate() takes for granted.
+// exact, and O(n log n)
+template <typename T>
+bool is_simple(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts = nullptr, size_t holes = 0);
+
+// cuts a polygon of one ring that crosses itself into simple ones at every
+// point where it does, for triangulate_batch(). `pieces` gets their vertices,
+// the crossing points among them, and piece k runs from ring_starts[k] up to
+// ring_starts[k + 1]. pieces that wind cw, such as the far side of a vertex
+// dragged across an edge, are turned around, and pieces of no area dropped. a
+// loop inside another one isn't cut out of it. where more than two edges
+// cross at one point, the points worked out for every pair of them are
+// merged into one. with int32_t coordinates the crossing points are rounded,
+// which can make edges meet again where they nearly did. returns the number
+// of pieces
+template <typename T>
+size_t split_simple(const vec2<T> *vertices, size_t n
+    , std::vector<vec2<T>> *pieces, std::vector<uint32_t> *ring_starts);
+
+// number of triangles triangulate_batch() writes for `polygons` polygons laid
+// out by `ring_starts`
+inline size_t batch_triangles(const uint32_t *ring_starts, size_t polygons) {
+  size_t count = 0;
+  for (size_t k = 0; k < polygons; k++)
+    count += max_triangles(ring_starts[k + 1] - ring_starts[k]);
+  return count;
+}
+
+// triangulates many independent polygons at once on `threads` worker threads,
+// or as many as there are cores if 0. polygon k is made of the vertices from
+// ring_starts[k] up to ring_starts[k + 1], so there are `polygons` + 1 of
+// those. the max_triangles() triangles of every polygon follow right after
+// the ones of the polygon before it in `indices`, as indices into all of
+// `vertices`. the ones that input that isn't a simple polygon comes up short
+// of are left degenerate. the `winding` of `options` is ignored, since it
+// has room for one polygon only. returns the number of triangles written
+template <typename T>
+size_t triangulate_batch(const vec2<T> *vertices, const uint32_t *ring_starts
+    , size_t polygons, const triangulate_options &options, uint32_t *indices
+    , unsigned threads = 0);
+
+// triangulates `count` polygons of `n` vertices each, stored one right after
+// the other. meant for lots of quads, pentagons and hexagons, which are done
+// eight at a time with vector instructions where the cpu has them. the n - 2
+// triangles of polygon k start at indices[3 * (n - 2) * k], as indices into
+// all of `vertices`. returns the number of triangles written
+size_t triangulate_small(const vertex *vertices, size_t n, size_t count
+    , uint32_t *indices);
+
+// a trapezoid of the decomposition below: the slab between the lines level
+// with vertices `top` and `bottom`, cut off by edges `left` and `right`, edge
+// i running from vertex i to the next one around its ring. -1 stands for
+// infinity. its neighbours above and below are the ones sharing its left and
+// its right edge, or -1 where there's none
+struct trapezoid
+{
+  int32_t left, right, top, bottom;
+  int32_t up_left, up_right, down_left, down_right;
+};
+
+// an inner node of the search structure asks whether the point lies above
+// vertex `key` (then on to `first`, otherwise `second`) or left of edge
+// `key`. a leaf holds the index of a trapezoid
+struct trapezoid_node
+{
+  uint8_t kind;
+  int32_t key, first, second;
+};
+
+// seidel's randomized trapezoidal decomposition of a polygon laid out as for
+// triangulate(), built in expected O(n log* n). the search structure built
+// along with it locates a point in expected O(log n), so a map of a large
+// polygon is worth keeping around for point location. the Trapezoidation
+// method triangulates through one of these. it points into `vertices`, which
+// has to outlive it
+template <typename T>
+struct trapezoid_map
+{
+  const vec2<T> *vertices;
+  // the vertex every vertex is followed by around its ring, as stored
+  std::vector<uint32_t> next;
+  // whether the outer ring winds cw, which puts the interior right of every
+  // edge instead of left
+  bool reversed;
+  std::vector<trapezoid> trapezoids;
+  std::vector<trapezoid_node> nodes;
+
+  trapezoid_map(const vec2<T> *n_vertices, size_t n
+      , const uint32_t *hole_starts = nullptr, size_t holes = 0);
+  // index of the trapezoid that `p` lies in
+  int32_t locate(const vec2<T> &p) const;
+  // whether trapezoid `t` is part of the polygon
+  bool inside(int32_t t) const;
+  bool contains(const vec2<T> &p) const {
+    return inside(locate(p));
+  }
+};
+
+// what separates the strips that stripify() writes when asked to, for
+// glPrimitiveRestartIndex()
+static const uint32_t strip_restart = UINT32_MAX;
+
+// rewrites `triangles` triangles, as triangulate() writes them along with
+// their neighbours, as triangle strips to draw with GL_TRIANGLE_STRIP, every
+// triangle winding the same way as before. with `restart` the strips are
+// separated by strip_restart, otherwise they're chained into a single one by
+// degenerate triangles. a refined mesh takes less than half the indices it
+// does as a list. a polygon triangulated without extra vertices gains less,
+// every ear being where a strip has to end. returns the number of indices
+// written to `strip`
+size_t stripify(const uint32_t *indices, const int32_t *neighbors
+    , size_t triangles, bool restart, std::vector<uint32_t> *strip);
+
+// average number of vertices a triangle costs to transform, as a fifo
+// post-transform cache of `cache_size` vertices would see the triangles go by.
+// 3 at worst, 0.5 for an ideal order over a large grid
+double acmr(const uint32_t *indices, size_t triangles, size_t n
+    , size_t cache_size = 16);
+
+struct cache_stats
+{
+  double acmr_before, acmr_after;
+};
+
+// reorders the `triangles` triangles in `indices`, over `n` vertices, for the
+// post-transform vertex cache, with forsyth's linear-time algorithm. the
+// triangles keep their corners as they were, degenerate ones like the
+// padding triangulate_batch() writes included, and `neighbors`, if given, is
+// rearranged along with them. returns the acmr() before and after
+cache_stats optimize_vertex_cache(uint32_t *indices, int32_t *neighbors
+    , size_t triangles, size_t n, size_t cache_size = 16);
+
+// renumbers the `n` vertices in the order the triangles first use them, so
+// that fetching them walks through memory. meant to follow
+// optimize_vertex_cache(). moves `vertices` around and rewrites `indices`,
+// vertices no triangle uses going last. remap[v], if given, is where vertex v
+// went
+template <typename T>
+void optimize_vertex_fetch(vec2<T> *vertices, size_t n, uint32_t *indices
+    , size_t triangles, uint32_t *remap = nullptr);
+
+// space-filling curves sort_spatially() can order triangles along
+enum space_curve
+{
+  Morton = 0,
+  Hilbert = 1
+};
+
+// reorders the `triangles` triangles in `indices` along a space-filling curve
+// through their centroids, so that triangles close to each other in the plane
+// are close to each other in the buffer too, and then renumbers the `n`
+// vertices as optimize_vertex_fetch() does. for renderers that cull or bin by
+// area, and for queries that walk the mesh. the hilbert curve never jumps, the
+// morton one is a little cheaper to compute. `neighbors`, if given, is
+// rearranged along with the triangles and remap[v], if given, is where vertex
+// v went. the sort is a radix sort over the curve positions, run on `threads`
+// threads for large meshes, 0 meaning one per core
+template <typename T>
+void sort_spatially(vec2<T> *vertices, size_t n, uint32_t *indices
+    , int32_t *neighbors, size_t triangles, int curve = Hilbert
+    , uint32_t *remap = nullptr, unsigned threads = 0);
+
+// what refine() keeps adding vertices until
+struct refine_options
+{
+  // smallest angle a triangle may have, in degrees. up to about 30 this
+  // always finishes, angles of the polygon itself that are already smaller
+  // are left alone
+  double min_angle;
+  // largest area a triangle may have anywhere, or 0 for no limit
+  double max_area;
+  // largest area a triangle around (x, y) may have, asked at the centroid of
+  // every triangle. 0 or less means no limit there. applies on top of
+  // max_area
+  std::function<double(double x, double y)> size;
+  // gives up after adding this many vertices, or never if 0
+  size_t max_steiner;
+
+  refine_options() : min_angle(20), max_area(0), max_steiner(0) {}
+};
+
+// a quality mesh of the polygon laid out as for triangulate(), for finite
+// element work: its constrained delaunay triangulation, refined after ruppert
+// and chew by adding vertices at the circumcenters of triangles that are too
+// thin or too large, and halfway along the edges they would crowd. every
+// vertex goes in by retriangulating the cavity of triangles whose
+// circumcircles it falls in (bowyer-watson), so the cost per vertex stays
+// constant. `out_vertices` gets the polygon's vertices followed by the new
+// ones and `indices` three indices into it per triangle. returns the number
+// of triangles
+template <typename T>
+size_t refine(const vec2<T> *vertices, size_t n, const uint32_t *hole_starts
+    , size_t holes, const refine_options &options
+    , std::vector<vec2<T>> *out_vertices, std::vector<uint32_t> *indices);
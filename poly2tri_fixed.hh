@@ -0,0 +1,105 @@
+#pragma once
+
+#include "poly2tri.hh"
+#include <array>
+#include <type_traits>
+#include <utility>
+
+// triangulation of polygons with a vertex count known at compile time, so that
+// fixed shapes like glyphs and icons can be triangulated by the compiler:
+//
+//   constexpr vec2<float> arrow[] = { { 0, 0 }, { 2, 1 }, { 0, 2 }, { 1, 1 } };
+//   constexpr std::array<uint32_t, 6> indices = triangulate_fixed(arrow);
+//
+// needs c++14, unlike the rest of the library. it's a plain ear clipper, which
+// for at most 16 vertices comes down to a few loops the compiler can unroll
+// completely when it runs at runtime after all
+
+// in double for floating point coordinates and in 64 bits for integer ones,
+// where it's exact
+template <typename T>
+using fixed_wide = typename std::conditional<std::is_floating_point<T>::value
+  , double, long long>::type;
+
+template <typename T>
+constexpr fixed_wide<T> fixed_orient(const vec2<T> &a, const vec2<T> &b
+    , const vec2<T> &c) {
+  return ((fixed_wide<T>)b.x - (fixed_wide<T>)a.x)
+    * ((fixed_wide<T>)c.y - (fixed_wide<T>)a.y)
+    - ((fixed_wide<T>)b.y - (fixed_wide<T>)a.y)
+    * ((fixed_wide<T>)c.x - (fixed_wide<T>)a.x);
+}
+
+// std::array can't be written to in a constant expression before c++17, so
+// the indices are collected in one of these first
+template <size_t M>
+struct fixed_indices
+{
+  uint32_t v[M];
+};
+
+template <size_t M, size_t... I>
+constexpr std::array<uint32_t, M> fixed_to_array(const fixed_indices<M> &b
+    , std::index_sequence<I...>) {
+  return {{ b.v[I]... }};
+}
+
+// `V` is anything that indexes like an array of N vertices
+template <size_t N, typename T, typename V>
+constexpr std::array<uint32_t, 3 * (N - 2)> fixed_triangulate(const V &v) {
+  static_assert(N >= 3 && N <= 16, "triangulate_fixed() takes 3 to 16 "
+      "vertices");
+  uint32_t prev[N] = {}, next[N] = {};
+  for (size_t i = 0; i < N; i++) {
+    prev[i] = i == 0 ? N - 1 : i - 1;
+    next[i] = i + 1 == N ? 0 : i + 1;
+  }
+  fixed_indices<3 * (N - 2)> out = {};
+  size_t count = 0;
+  uint32_t node = 0;
+  for (size_t remaining = N; remaining > 3; remaining--) {
+    // the first ear from `node` on. without one the polygon isn't a simple
+    // ccw one, and the first convex vertex is clipped instead, or failing
+    // that `node` itself
+    uint32_t ear = N, convex = N, u = node;
+    for (size_t k = 0; k < remaining && ear == N; k++, u = next[u]) {
+      const vec2<T> &a = v[prev[u]], &b = v[u], &c = v[next[u]];
+      if (fixed_orient(a, b, c) <= 0)
+        continue;
+      if (convex == N)
+        convex = u;
+      bool empty = true;
+      for (uint32_t w = next[next[u]]; w != prev[u] && empty; w = next[w])
+        empty = fixed_orient(a, b, v[w]) < 0 || fixed_orient(b, c, v[w]) < 0
+          || fixed_orient(c, a, v[w]) < 0;
+      if (empty)
+        ear = u;
+    }
+    if (ear == N)
+      ear = convex != N ? convex : node;
+    out.v[count++] = prev[ear];
+    out.v[count++] = ear;
+    out.v[count++] = next[ear];
+    next[prev[ear]] = next[ear];
+    prev[next[ear]] = prev[ear];
+    node = next[ear];
+  }
+  out.v[count++] = prev[node];
+  out.v[count++] = node;
+  out.v[count++] = next[node];
+  return fixed_to_array(out, std::make_index_sequence<3 * (N - 2)>());
+}
+
+// triangulates the ccw polygon made of the N vertices of `v` into N - 2
+// triangles, three indices each
+template <size_t N, typename T>
+constexpr std::array<uint32_t, 3 * (N - 2)> triangulate_fixed(
+    const vec2<T> (&v)[N]) {
+  return fixed_triangulate<N, T>(v);
+}
+
+template <size_t N, typename T>
+constexpr std::array<uint32_t, 3 * (N - 2)> triangulate_fixed(
+    const std::array<vec2<T>, N> &v) {
+  return fixed_triangulate<N, T>(v);
+}
@@ -0,0 +1,289 @@
+#include "triangulators.hh"
+#include <cmath>
+
+// the slow paths of orient2d() and incircle2d(), after jonathan shewchuk's
+// "adaptive precision floating-point arithmetic and fast robust geometric
+// predicates". a number is carried as an expansion: a sum of doubles that
+// don't overlap, stored from the smallest to the largest, whose exact value is
+// the exact result. each stage only goes on to the next, more precise one when
+// its own error bound can't settle the sign, so near-degenerate input pays for
+// as much precision as it needs and no more
+
+static const double splitter = 134217729.0 // 2^27 + 1
+  , result_bound = (3 + 8 * epsilon) * epsilon
+  , orient_bound_b = (2 + 12 * epsilon) * epsilon
+  , orient_bound_c = (9 + 64 * epsilon) * epsilon * epsilon
+  , incircle_bound_b = (4 + 48 * epsilon) * epsilon
+  , incircle_bound_c = (44 + 576 * epsilon) * epsilon * epsilon;
+
+// x + y = a + b exactly, given |a| >= |b|
+static inline void fast_two_sum(double a, double b, double &x, double &y) {
+  x = a + b;
+  y = b - (x - a);
+}
+
+static inline void two_sum(double a, double b, double &x, double &y) {
+  x = a + b;
+  double bv = x - a, av = x - bv;
+  y = (a - av) + (b - bv);
+}
+
+// the rounding error y of x = a - b
+static inline double two_diff_tail(double a, double b, double x) {
+  double bv = a - x, av = x + bv;
+  return (a - av) + (bv - b);
+}
+
+static inline void two_diff(double a, double b, double &x, double &y) {
+  x = a - b;
+  y = two_diff_tail(a, b, x);
+}
+
+// splits a into two halves of 26 bits each
+static inline void split(double a, double &hi, double &lo) {
+  double c = splitter * a, big = c - a;
+  hi = c - big;
+  lo = a - hi;
+}
+
+static inline void two_product(double a, double b, double &x, double &y) {
+  x = a * b;
+  double ahi, alo, bhi, blo;
+  split(a, ahi, alo);
+  split(b, bhi, blo);
+  double err = x - ahi * bhi - alo * bhi - ahi * blo;
+  y = alo * blo - err;
+}
+
+// (a1 + a0) - (b1 + b0) as four components
+static void two_two_diff(double a1, double a0, double b1, double b0
+    , double *x) {
+  double i, j, k;
+  two_diff(a0, b0, i, x[0]);
+  two_sum(a1, i, j, k);
+  two_diff(k, b1, i, x[1]);
+  two_sum(j, i, x[3], x[2]);
+}
+
+static double estimate(size_t len, const double *e) {
+  double sum = e[0];
+  for (size_t i = 1; i < len; i++)
+    sum += e[i];
+  return sum;
+}
+
+// h = e + f with the zeros left out. h needs room for elen + flen
+// components, and is never empty
+static size_t expansion_sum(size_t elen, const double *e, size_t flen
+    , const double *f, double *h) {
+  size_t ei = 0, fi = 0, hi = 0;
+  double q, hh;
+  // the components are merged by magnitude
+  auto take = [&]() {
+    if (fi == flen || (ei < elen
+          && (f[fi] > e[ei]) == (f[fi] > -e[ei])))
+      return e[ei++];
+    return f[fi++];
+  };
+  q = take();
+  while (ei < elen || fi < flen) {
+    two_sum(q, take(), q, hh);
+    if (hh != 0)
+      h[hi++] = hh;
+  }
+  if (q != 0 || hi == 0)
+    h[hi++] = q;
+  return hi;
+}
+
+// h = b * e with the zeros left out. h needs room for 2 * elen components
+static size_t scale_expansion(size_t elen, const double *e, double b
+    , double *h) {
+  size_t hi = 0;
+  double q, hh;
+  two_product(e[0], b, q, hh);
+  if (hh != 0)
+    h[hi++] = hh;
+  for (size_t i = 1; i < elen; i++) {
+    double p1, p0, sum;
+    two_product(e[i], b, p1, p0);
+    two_sum(q, p0, sum, hh);
+    if (hh != 0)
+      h[hi++] = hh;
+    fast_two_sum(p1, sum, q, hh);
+    if (hh != 0)
+      h[hi++] = hh;
+  }
+  if (q != 0 || hi == 0)
+    h[hi++] = q;
+  return hi;
+}
+
+double orient2d_exact(double ax, double ay, double bx, double by, double cx
+    , double cy, double sum) {
+  double acx = ax - cx, bcx = bx - cx, acy = ay - cy, bcy = by - cy;
+  double left, left_tail, right, right_tail, b[4];
+  two_product(acx, bcy, left, left_tail);
+  two_product(acy, bcx, right, right_tail);
+  two_two_diff(left, left_tail, right, right_tail, b);
+  double det = estimate(4, b), bound = orient_bound_b * sum;
+  if (det >= bound || -det >= bound)
+    return det;
+
+  // the differences above were rounded. if they weren't after all, b is
+  // exact, otherwise their first order error is taken in
+  double acx_tail = two_diff_tail(ax, cx, acx)
+    , bcx_tail = two_diff_tail(bx, cx, bcx)
+    , acy_tail = two_diff_tail(ay, cy, acy)
+    , bcy_tail = two_diff_tail(by, cy, bcy);
+  if (acx_tail == 0 && acy_tail == 0 && bcx_tail == 0 && bcy_tail == 0)
+    return det;
+  bound = orient_bound_c * sum + result_bound * std::fabs(det);
+  det += (acx * bcy_tail + bcy * acx_tail)
+    - (acy * bcx_tail + bcx * acy_tail);
+  if (det >= bound || -det >= bound)
+    return det;
+
+  // and finally every term exactly
+  double s1, s0, t1, t0, u[4], c1[8], c2[12], d[16];
+  two_product(acx_tail, bcy, s1, s0);
+  two_product(acy_tail, bcx, t1, t0);
+  two_two_diff(s1, s0, t1, t0, u);
+  size_t c1_len = expansion_sum(4, b, 4, u, c1);
+  two_product(acx, bcy_tail, s1, s0);
+  two_product(acy, bcx_tail, t1, t0);
+  two_two_diff(s1, s0, t1, t0, u);
+  size_t c2_len = expansion_sum(c1_len, c1, 4, u, c2);
+  two_product(acx_tail, bcy_tail, s1, s0);
+  two_product(acy_tail, bcx_tail, t1, t0);
+  two_two_diff(s1, s0, t1, t0, u);
+  size_t d_len = expansion_sum(c2_len, c2, 4, u, d);
+  return d[d_len - 1];
+}
+
+// h = e * f with the zeros left out, for e of up to 16 components and f of
+// up to 32. h needs room for 2 * elen * flen components
+static size_t product_expansion(size_t elen, const double *e, size_t flen
+    , const double *f, double *h) {
+  double part[32], sum[1024];
+  size_t h_len = scale_expansion(elen, e, f[0], h);
+  for (size_t i = 1; i < flen; i++) {
+    size_t part_len = scale_expansion(elen, e, f[i], part)
+      , sum_len = expansion_sum(h_len, h, part_len, part, sum);
+    for (h_len = 0; h_len < sum_len; h_len++)
+      h[h_len] = sum[h_len];
+  }
+  return h_len;
+}
+
+// the lifted term of a (a.x^2 + a.y^2) (b.x c.y - c.x b.y) exactly, every
+// coordinate a two component difference to d. in up to 512 components
+static size_t lifted_exact(const double *ax, const double *ay
+    , const double *bx, const double *by, const double *cx, const double *cy
+    , double *h) {
+  double p[8], q[8], bc[16], xx[8], yy[8], lift[16];
+  size_t p_len = product_expansion(2, bx, 2, cy, p)
+    , q_len = product_expansion(2, cx, 2, by, q);
+  for (size_t i = 0; i < q_len; i++)
+    q[i] = -q[i];
+  size_t bc_len = expansion_sum(p_len, p, q_len, q, bc)
+    , xx_len = product_expansion(2, ax, 2, ax, xx)
+    , yy_len = product_expansion(2, ay, 2, ay, yy)
+    , lift_len = expansion_sum(xx_len, xx, yy_len, yy, lift);
+  return product_expansion(lift_len, lift, bc_len, bc, h);
+}
+
+// the whole determinant exactly, from the differences to d as two component
+// expansions
+static double incircle2d_exact(double ax, double ay, double bx, double by
+    , double cx, double cy, double dx, double dy) {
+  double adx[2], ady[2], bdx[2], bdy[2], cdx[2], cdy[2];
+  two_diff(ax, dx, adx[1], adx[0]);
+  two_diff(ay, dy, ady[1], ady[0]);
+  two_diff(bx, dx, bdx[1], bdx[0]);
+  two_diff(by, dy, bdy[1], bdy[0]);
+  two_diff(cx, dx, cdx[1], cdx[0]);
+  two_diff(cy, dy, cdy[1], cdy[0]);
+  double a[512], b[512], c[512], ab[1024], det[1536];
+  size_t a_len = lifted_exact(adx, ady, bdx, bdy, cdx, cdy, a)
+    , b_len = lifted_exact(bdx, bdy, cdx, cdy, adx, ady, b)
+    , c_len = lifted_exact(cdx, cdy, adx, ady, bdx, bdy, c)
+    , ab_len = expansion_sum(a_len, a, b_len, b, ab)
+    , det_len = expansion_sum(ab_len, ab, c_len, c, det);
+  return det[det_len - 1];
+}
+
+// alift (bx cy - cx by) exactly for rounded differences, in up to 32
+// components
+static size_t lifted_rounded(double ax, double ay, double bx, double by
+    , double cx, double cy, double *h) {
+  double p1, p0, q1, q0, bc[4], x[8], xx[16], y[8], yy[16];
+  two_product(bx, cy, p1, p0);
+  two_product(cx, by, q1, q0);
+  two_two_diff(p1, p0, q1, q0, bc);
+  size_t x_len = scale_expansion(4, bc, ax, x)
+    , xx_len = scale_expansion(x_len, x, ax, xx)
+    , y_len = scale_expansion(4, bc, ay, y)
+    , yy_len = scale_expansion(y_len, y, ay, yy);
+  return expansion_sum(xx_len, xx, yy_len, yy, h);
+}
+
+static double incircle2d_adapt(double ax, double ay, double bx, double by
+    , double cx, double cy, double dx, double dy, double permanent) {
+  double adx = ax - dx, bdx = bx - dx, cdx = cx - dx
+    , ady = ay - dy, bdy = by - dy, cdy = cy - dy;
+  double a[32], b[32], c[32], ab[64], det[96];
+  size_t a_len = lifted_rounded(adx, ady, bdx, bdy, cdx, cdy, a)
+    , b_len = lifted_rounded(bdx, bdy, cdx, cdy, adx, ady, b)
+    , c_len = lifted_rounded(cdx, cdy, adx, ady, bdx, bdy, c)
+    , ab_len = expansion_sum(a_len, a, b_len, b, ab)
+    , det_len = expansion_sum(ab_len, ab, c_len, c, det);
+  double estimated = estimate(det_len, det)
+    , bound = incircle_bound_b * permanent;
+  if (estimated >= bound || -estimated >= bound)
+    return estimated;
+  // exact already if the differences were, otherwise their first order
+  // error is taken in
+  double adx_tail = two_diff_tail(ax, dx, adx)
+    , ady_tail = two_diff_tail(ay, dy, ady)
+    , bdx_tail = two_diff_tail(bx, dx, bdx)
+    , bdy_tail = two_diff_tail(by, dy, bdy)
+    , cdx_tail = two_diff_tail(cx, dx, cdx)
+    , cdy_tail = two_diff_tail(cy, dy, cdy);
+  if (adx_tail == 0 && ady_tail == 0 && bdx_tail == 0 && bdy_tail == 0
+      && cdx_tail == 0 && cdy_tail == 0)
+    return det[det_len - 1];
+  bound = incircle_bound_c * permanent + result_bound * std::fabs(estimated);
+  estimated += ((adx * adx + ady * ady) * ((bdx * cdy_tail + cdy * bdx_tail)
+        - (bdy * cdx_tail + cdx * bdy_tail))
+      + 2 * (adx * adx_tail + ady * ady_tail) * (bdx * cdy - bdy * cdx))
+    + ((bdx * bdx + bdy * bdy) * ((cdx * ady_tail + ady * cdx_tail)
+        - (cdy * adx_tail + adx * cdy_tail))
+      + 2 * (bdx * bdx_tail + bdy * bdy_tail) * (cdx * ady - cdy * adx))
+    + ((cdx * cdx + cdy * cdy) * ((adx * bdy_tail + bdy * adx_tail)
+        - (ady * bdx_tail + bdx * ady_tail))
+      + 2 * (cdx * cdx_tail + cdy * cdy_tail) * (adx * bdy - ady * bdx));
+  if (estimated >= bound || -estimated >= bound)
+    return estimated;
+  return incircle2d_exact(ax, ay, bx, by, cx, cy, dx, dy);
+}
+
+double incircle2d(double ax, double ay, double bx, double by, double cx
+    , double cy, double dx, double dy) {
+  double adx = ax - dx, bdx = bx - dx, cdx = cx - dx
+    , ady = ay - dy, bdy = by - dy, cdy = cy - dy;
+  double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy
+    , cdxady = cdx * ady, adxcdy = adx * cdy
+    , adxbdy = adx * bdy, bdxady = bdx * ady
+    , alift = adx * adx + ady * ady, blift = bdx * bdx + bdy * bdy
+    , clift = cdx * cdx + cdy * cdy;
+  double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy)
+    + clift * (adxbdy - bdxady)
+    , permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * alift
+    + (std::fabs(cdxady) + std::fabs(adxcdy)) * blift
+    + (std::fabs(adxbdy) + std::fabs(bdxady)) * clift
+    , bound = incircle_bound * permanent;
+  if (det > bound || -det > bound)
+    return det;
+  return incircle2d_adapt(ax, ay, bx, by, cx, cy, dx, dy, permanent);
+}
@@ -0,0 +1,411 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+// ruppert's delaunay refinement, the way shewchuk lays it out in "delaunay
+// refinement algorithms for triangular mesh generation". it starts from the
+// constrained delaunay triangulation, whose only constraints are its boundary
+// edges, and keeps it that way: boundary edges are only ever split in two, and
+// every vertex goes in through bowyer-watson, replacing the triangles whose
+// circumcircles it falls in with a fan around it. removed triangles are marked
+// with a first corner of `none` and their slots reused
+
+static const uint32_t none = UINT32_MAX;
+
+template <typename T>
+static inline bool same(const vec2<T> &a, const vec2<T> &b) {
+  return a.x == b.x && a.y == b.y;
+}
+
+template <typename T>
+struct refiner
+{
+  // a triangle, or one of its edges, waiting to be looked at. it's out of
+  // date once the slot holds different corners
+  struct queued
+  {
+    int32_t t, k;
+    uint32_t a, b, c;
+  };
+  // an edge around the cavity, with the triangle outside it
+  struct rim
+  {
+    uint32_t a, b;
+    int32_t outside;
+  };
+
+  std::vector<vec2<T>> &vertices;
+  const refine_options &options;
+  size_t inputs, added;
+  // sine squared of the smallest angle allowed
+  double sin2;
+  mesh m;
+  std::vector<int32_t> free;
+  // the edge of the polygon every added vertex lies on, or none for the ones
+  // inside
+  std::vector<diagonal> on;
+  // triangles in the cavity being dug out carry the current stamp
+  std::vector<uint32_t> stamps;
+  uint32_t stamp;
+  // the new triangles around a vertex going in, by their first and second
+  // corner, which is how they find each other
+  std::vector<int32_t> by_first, by_second;
+  std::vector<int32_t> cavity, fresh;
+  std::vector<rim> rims;
+  std::vector<queued> segments, bad, crowded;
+  size_t bad_head;
+
+  refiner(std::vector<vec2<T>> &n_vertices, size_t n
+      , const refine_options &n_options)
+    : vertices(n_vertices), options(n_options), inputs(n), added(0)
+    , sin2(std::pow(std::sin(n_options.min_angle * std::atan(1) / 45), 2))
+    , on(n, diagonal { none, none }), stamp(0), by_first(n, -1)
+    , by_second(n, -1), bad_head(0) {}
+
+  double distance2(uint32_t p, uint32_t q) const {
+    double dx = (double)vertices[p].x - (double)vertices[q].x
+      , dy = (double)vertices[p].y - (double)vertices[q].y;
+    return dx * dx + dy * dy;
+  }
+
+  static vec2<T> point(double x, double y) {
+    if (std::is_integral<T>::value)
+      x = std::round(x), y = std::round(y);
+    return vec2<T> { (T)x, (T)y };
+  }
+
+  // whether p lies inside the circle that has edge ab for its diameter
+  bool crowds(uint32_t a, uint32_t b, uint32_t p) const {
+    const vec2<T> &va = vertices[a], &vb = vertices[b], &vp = vertices[p];
+    return ((double)va.x - (double)vp.x) * ((double)vb.x - (double)vp.x)
+      + ((double)va.y - (double)vp.y) * ((double)vb.y - (double)vp.y) < 0;
+  }
+
+  queued entry(int32_t t, int32_t k) const {
+    const uint32_t *c = &m.corners[3 * t];
+    return queued { t, k, c[0], c[1], c[2] };
+  }
+
+  bool current(const queued &q) const {
+    const uint32_t *c = &m.corners[3 * q.t];
+    return c[0] == q.a && c[1] == q.b && c[2] == q.c;
+  }
+
+  // the edge of the polygon that edge ab of the mesh is a piece of
+  diagonal segment_of(uint32_t a, uint32_t b) const {
+    if (a < inputs)
+      return b < inputs ? diagonal { a, b } : on[b];
+    return on[a];
+  }
+
+  // a thin triangle whose shortest edge joins two vertices on edges of the
+  // polygon that meet at a sharp corner, equally far from it, only shows the
+  // corner's own angle. splitting it would just start another ring of them
+  // closer in, so it's left alone
+  bool across_corner(uint32_t p, uint32_t q) const {
+    if (p < inputs || q < inputs || on[p].a == none || on[q].a == none)
+      return false;
+    const diagonal &s = on[p], &r = on[q];
+    uint32_t corner = s.a == r.a || s.a == r.b ? s.a
+      : s.b == r.a || s.b == r.b ? s.b : none;
+    if (corner == none || (s.a == r.a && s.b == r.b))
+      return false;
+    // closer to each other than to the corner, it's under 60 degrees
+    double dp = distance2(p, corner), dq = distance2(q, corner);
+    return std::fabs(dp - dq) <= 1e-3 * std::max(dp, dq)
+      && distance2(p, q) < dp;
+  }
+
+  bool is_bad(int32_t t) const {
+    const uint32_t *c = &m.corners[3 * t];
+    const vec2<T> &a = vertices[c[0]], &b = vertices[c[1]]
+      , &d = vertices[c[2]];
+    double area2 = (double)orient(a, b, d), area = area2 / 2;
+    if (area <= 0)
+      return false;
+    if (options.max_area > 0 && area > options.max_area)
+      return true;
+    if (options.size) {
+      double size = options.size(((double)a.x + (double)b.x + (double)d.x) / 3
+          , ((double)a.y + (double)b.y + (double)d.y) / 3);
+      if (size > 0 && area > size)
+        return true;
+    }
+    // the smallest angle faces the shortest edge, and its sine is twice the
+    // area over the lengths of the other two
+    double l[3] = { distance2(c[1], c[2]), distance2(c[2], c[0])
+      , distance2(c[0], c[1]) };
+    int k = l[0] <= l[1] && l[0] <= l[2] ? 0 : l[1] <= l[2] ? 1 : 2;
+    if (area2 * area2 >= sin2 * l[(k + 1) % 3] * l[(k + 2) % 3])
+      return false;
+    return !across_corner(c[(k + 1) % 3], c[(k + 2) % 3]);
+  }
+
+  void check(int32_t t) {
+    if (is_bad(t))
+      bad.push_back(entry(t, -1));
+    const uint32_t *c = &m.corners[3 * t];
+    for (int k = 0; k < 3; k++)
+      if (m.neighbors[3 * t + k] == -1
+          && crowds(c[k], c[(k + 1) % 3], c[(k + 2) % 3]))
+        segments.push_back(entry(t, k));
+  }
+
+  int32_t add_triangle(uint32_t a, uint32_t b, uint32_t c) {
+    int32_t t;
+    if (free.empty()) {
+      t = m.corners.size() / 3;
+      m.corners.resize(m.corners.size() + 3);
+      m.neighbors.resize(m.corners.size());
+      stamps.push_back(0);
+    } else {
+      t = free.back();
+      free.pop_back();
+    }
+    m.corners[3 * t] = a, m.corners[3 * t + 1] = b, m.corners[3 * t + 2] = c;
+    return t;
+  }
+
+  uint32_t add_vertex(const vec2<T> &p, diagonal segment) {
+    vertices.push_back(p);
+    on.push_back(segment);
+    by_first.push_back(-1);
+    by_second.push_back(-1);
+    return vertices.size() - 1;
+  }
+
+  void drop_vertex() {
+    vertices.pop_back();
+    on.pop_back();
+    by_first.pop_back();
+    by_second.pop_back();
+  }
+
+  // the triangle `p` lies in, walking over from triangle t. past the
+  // boundary there's nothing to walk to, so it's -1 then and the edge it
+  // would have crossed goes to `hit`
+  int32_t locate(int32_t t, const vec2<T> &p, queued *hit) const {
+    for (size_t step = 0; 3 * step < m.corners.size(); step++) {
+      const uint32_t *c = &m.corners[3 * t];
+      // starting from a different edge every time keeps the walk from
+      // circling
+      int k = step % 3, j = 0;
+      while (j < 3 && orient(vertices[c[(k + j) % 3]]
+            , vertices[c[(k + j + 1) % 3]], p) >= 0)
+        j++;
+      if (j == 3)
+        return t;
+      k = (k + j) % 3;
+      if (m.neighbors[3 * t + k] == -1) {
+        *hit = entry(t, k);
+        return -1;
+      }
+      t = m.neighbors[3 * t + k];
+    }
+    hit->t = -1;
+    return -1;
+  }
+
+  // puts vertex p, which lies in triangle `start` or on its edge `split`,
+  // into the mesh. a circumcenter (split -1) that would crowd an edge of
+  // the boundary stays out, and those edges go to `crowded`. returns whether
+  // p went in
+  bool insert(uint32_t p, int32_t start, int split) {
+    const vec2<T> &vp = vertices[p];
+    uint32_t *c;
+    int32_t *nb;
+    stamp++;
+    cavity.assign(1, start);
+    stamps[start] = stamp;
+    for (size_t i = 0; i < cavity.size(); i++)
+      for (int k = 0; k < 3; k++) {
+        int32_t u = m.neighbors[3 * cavity[i] + k];
+        if (u == -1 || stamps[u] == stamp)
+          continue;
+        c = &m.corners[3 * u];
+        if (incircle(vertices[c[0]], vertices[c[1]], vertices[c[2]], vp) > 0) {
+          stamps[u] = stamp;
+          cavity.push_back(u);
+        }
+      }
+
+    // the cavity has to be a star around p for the fan to fill it
+    rims.clear();
+    crowded.clear();
+    for (int32_t t : cavity)
+      for (int k = 0; k < 3; k++) {
+        int32_t u = m.neighbors[3 * t + k];
+        if ((u != -1 && stamps[u] == stamp) || (t == start && k == split))
+          continue;
+        uint32_t a = m.corners[3 * t + k], b = m.corners[3 * t + (k + 1) % 3];
+        if (split == -1 && u == -1 && crowds(a, b, p))
+          crowded.push_back(entry(t, k));
+        else if (same(vertices[a], vp) || same(vertices[b], vp)
+            || orient(vertices[a], vertices[b], vp) <= 0)
+          return false;
+        rims.push_back(rim { a, b, u });
+      }
+    if (!crowded.empty())
+      return false;
+
+    for (int32_t t : cavity) {
+      m.corners[3 * t] = none;
+      free.push_back(t);
+    }
+    fresh.clear();
+    for (const rim &r : rims) {
+      int32_t t = add_triangle(r.a, r.b, p);
+      c = m.corners.data();
+      nb = m.neighbors.data();
+      nb[3 * t] = r.outside;
+      if (r.outside != -1)
+        for (int j = 0; j < 3; j++)
+          if (c[3 * r.outside + j] == r.b
+              && c[3 * r.outside + (j + 1) % 3] == r.a)
+            nb[3 * r.outside + j] = t;
+      by_first[r.a] = t;
+      by_second[r.b] = t;
+      fresh.push_back(t);
+    }
+    c = m.corners.data();
+    nb = m.neighbors.data();
+    // the fan's own edges, bp of abp being pb of bxp. around the split edge
+    // there's no such triangle and the halves end up on the boundary
+    for (int32_t t : fresh) {
+      nb[3 * t + 1] = by_first[c[3 * t + 1]];
+      nb[3 * t + 2] = by_second[c[3 * t]];
+    }
+    for (int32_t t : fresh)
+      by_first[c[3 * t]] = by_second[c[3 * t + 1]] = -1;
+    for (int32_t t : fresh)
+      check(t);
+    added++;
+    return true;
+  }
+
+  // where to split edge ab of the boundary. an edge with a vertex of the
+  // polygon at just one end is split a power of two away from it, so that the
+  // vertices put in around a sharp corner line up on circles around it and
+  // stop crowding each other's edges
+  vec2<T> split_point(uint32_t a, uint32_t b) const {
+    double f = 0.5;
+    if ((a < inputs) != (b < inputs)) {
+      double length = std::sqrt(distance2(a, b))
+        , d = std::exp2(std::round(std::log2(length / 2)));
+      if (d > length * 2 / 3)
+        d /= 2;
+      f = a < inputs ? d / length : 1 - d / length;
+    }
+    const vec2<T> &va = vertices[a], &vb = vertices[b];
+    return point((double)va.x + f * ((double)vb.x - (double)va.x)
+        , (double)va.y + f * ((double)vb.y - (double)va.y));
+  }
+
+  bool split(const queued &q) {
+    if (!current(q))
+      return false;
+    uint32_t a = m.corners[3 * q.t + q.k]
+      , b = m.corners[3 * q.t + (q.k + 1) % 3];
+    vec2<T> p = split_point(a, b);
+    // too short to split at this precision
+    if (same(p, vertices[a]) || same(p, vertices[b]))
+      return false;
+    if (insert(add_vertex(p, segment_of(a, b)), q.t, q.k))
+      return true;
+    drop_vertex();
+    return false;
+  }
+
+  vec2<T> circumcenter(int32_t t) const {
+    const uint32_t *c = &m.corners[3 * t];
+    const vec2<T> &a = vertices[c[0]], &b = vertices[c[1]]
+      , &d = vertices[c[2]];
+    double bx = (double)b.x - (double)a.x, by = (double)b.y - (double)a.y
+      , dx = (double)d.x - (double)a.x, dy = (double)d.y - (double)a.y
+      , b2 = bx * bx + by * by, d2 = dx * dx + dy * dy
+      , det = 2 * (bx * dy - by * dx);
+    return point((double)a.x + (dy * b2 - by * d2) / det
+        , (double)a.y + (bx * d2 - dx * b2) / det);
+  }
+
+  bool out_of_vertices() const {
+    return options.max_steiner != 0 && added >= options.max_steiner;
+  }
+
+  // edges of the boundary that are crowded go first, as ruppert's algorithm
+  // has it, then the bad triangles in the order they came up
+  void run() {
+    for (size_t t = 0; 3 * t < m.corners.size(); t++)
+      check(t);
+    while (!out_of_vertices()) {
+      if (!segments.empty()) {
+        queued q = segments.back();
+        segments.pop_back();
+        if (current(q))
+          split(q);
+        continue;
+      }
+      if (bad_head == bad.size())
+        break;
+      queued q = bad[bad_head++];
+      if (bad_head > 4096 && 2 * bad_head > bad.size()) {
+        bad.erase(bad.begin(), bad.begin() + bad_head);
+        bad_head = 0;
+      }
+      if (!current(q) || !is_bad(q.t))
+        continue;
+      vec2<T> center = circumcenter(q.t);
+      queued hit = queued { -1, -1, none, none, none };
+      int32_t t = locate(q.t, center, &hit);
+      // a circumcenter past the boundary means the edge in between is in the
+      // way. once it's split the triangle may well be gone
+      if (t == -1) {
+        if (hit.t != -1 && split(hit))
+          bad.push_back(q);
+        continue;
+      }
+      if (insert(add_vertex(center, diagonal { none, none }), t, -1))
+        continue;
+      drop_vertex();
+      std::vector<queued> in_the_way;
+      in_the_way.swap(crowded);
+      bool any = false;
+      for (const queued &s : in_the_way)
+        any = split(s) || any;
+      if (any)
+        bad.push_back(q);
+    }
+  }
+};
+
+template <typename T>
+size_t refine(const vec2<T> *vertices, size_t n, const uint32_t *hole_starts
+    , size_t holes, const refine_options &options
+    , std::vector<vec2<T>> *out_vertices, std::vector<uint32_t> *indices) {
+  out_vertices->assign(vertices, vertices + n);
+  indices->clear();
+  if (n < 3)
+    return 0;
+  refiner<T> r(*out_vertices, n, options);
+  // a cw outer ring is gone around the other way, as in triangulate()
+  bool reversed = signed_area(vertices, holes == 0 ? n : hole_starts[0]) < 0;
+  cdt_mesh(vertices, polygon_rings(n, hole_starts, holes, reversed), &r.m);
+  r.stamps.assign(r.m.corners.size() / 3, 0);
+  r.run();
+  for (size_t t = 0; 3 * t < r.m.corners.size(); t++)
+    if (r.m.corners[3 * t] != none)
+      indices->insert(indices->end(), &r.m.corners[3 * t]
+          , &r.m.corners[3 * t] + 3);
+  return indices->size() / 3;
+}
+
+#define INSTANTIATE(T) \
+  template size_t refine(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes \
+      , const refine_options &options, std::vector<vec2<T>> *out_vertices \
+      , std::vector<uint32_t> *indices);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
@@ -0,0 +1,372 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+// seidel's randomized incremental trapezoidation. the edges are added in
+// random order, each one splitting the trapezoids it crosses in two and
+// merging the pieces on either side that nothing separates anymore. every
+// trapezoid is a leaf of a search dag, whose inner nodes ask whether a point
+// lies above or below a vertex, or left or right of an edge, and the upper
+// end of every new edge is located in it before the edge is threaded down
+// through the trapezoids. rather than from the root, the edges that are
+// still to come are located from where they were found at the end of the
+// last of log* n phases, so that the expected cost of all the searches
+// together is O(n log* n) instead of O(n log n).
+//
+// the vertices are ordered by above(), with ties broken by index, so that no
+// two are level with each other. then every trapezoid has at most two
+// neighbours above, the ones sharing its left and right edge, and at most two
+// below
+
+enum trapezoid_node_kind
+{
+  sink_node,
+  y_node,
+  x_node
+};
+
+template <typename T>
+struct trapezoid_builder
+{
+  trapezoid_map<T> *map;
+  const vec2<T> *vertices;
+  const uint32_t *next;
+  std::vector<uint8_t> inserted;
+  // where the upper end of every edge still to come was last located
+  std::vector<int32_t> start;
+  std::vector<int32_t> crossed, left_part, right_part;
+  // the leaf of every trapezoid
+  std::vector<int32_t> sinks;
+
+  bool higher(uint32_t a, uint32_t b) const {
+    return above(vertices[a], vertices[b])
+      || (!above(vertices[b], vertices[a]) && a < b);
+  }
+  uint32_t upper(uint32_t e) const {
+    return higher(e, next[e]) ? e : next[e];
+  }
+  uint32_t lower(uint32_t e) const {
+    return higher(e, next[e]) ? next[e] : e;
+  }
+  // whether vertex v lies left of edge e, as seen looking up
+  bool left_of(uint32_t e, uint32_t v) const {
+    return orient(vertices[lower(e)], vertices[upper(e)], vertices[v]) > 0;
+  }
+  int32_t add_trapezoid(int32_t left, int32_t right, int32_t top
+      , int32_t bottom) {
+    std::vector<trapezoid> &traps = map->trapezoids;
+    trapezoid t = { left, right, top, bottom, -1, -1, -1, -1 };
+    traps.push_back(t);
+    map->nodes.push_back({ sink_node, (int32_t)traps.size() - 1, -1, -1 });
+    sinks.push_back(map->nodes.size() - 1);
+    return traps.size() - 1;
+  }
+  // the sink below `node` that vertex p falls in, with ties resolved as if
+  // p had moved a little towards vertex q
+  int32_t locate(uint32_t p, uint32_t q, int32_t node) const {
+    const std::vector<trapezoid_node> &nodes = map->nodes;
+    while (nodes[node].kind != sink_node) {
+      const trapezoid_node &d = nodes[node];
+      if (d.kind == y_node) {
+        bool up = (uint32_t)d.key == p ? higher(q, p) : higher(p, d.key);
+        node = up ? d.first : d.second;
+      } else {
+        uint32_t u = upper(d.key), l = lower(d.key);
+        // an endpoint shared with the edge, or one lying on it, is told
+        // apart by where q is
+        uint32_t r = p == u || p == l ? q : p;
+        typename wide_type<T>::type side = orient(vertices[l], vertices[u]
+            , vertices[r]);
+        if (side == 0)
+          side = orient(vertices[l], vertices[u], vertices[q]);
+        node = side > 0 ? d.first : d.second;
+      }
+    }
+    return node;
+  }
+  void insert(uint32_t s) {
+    std::vector<trapezoid> &traps = map->trapezoids;
+    std::vector<trapezoid_node> &nodes = map->nodes;
+    uint32_t p = upper(s), q = lower(s);
+    int32_t t = nodes[locate(p, q, start[s])].key;
+    // the trapezoids s crosses from top to bottom. one that isn't there
+    // means edges cross, and then s is left out
+    crossed.assign(1, t);
+    while (traps[t].bottom != -1 && higher(traps[t].bottom, q)) {
+      t = left_of(s, traps[t].bottom) ? traps[t].down_right
+        : traps[t].down_left;
+      if (t == -1)
+        return;
+      crossed.push_back(t);
+    }
+    bool p_new = !inserted[p], q_new = !inserted[q];
+    inserted[p] = inserted[q] = 1;
+    size_t k = crossed.size() - 1;
+    left_part.resize(k + 1);
+    right_part.resize(k + 1);
+
+    // the top of the first trapezoid, cut off by a new line level with p
+    trapezoid first = traps[crossed[0]];
+    int32_t cur_l = add_trapezoid(first.left, s, p, -1)
+      , cur_r = add_trapezoid(s, first.right, p, -1), top = -1;
+    if (p_new) {
+      top = add_trapezoid(first.left, first.right, first.top, p);
+      traps[top].up_left = first.up_left;
+      traps[top].up_right = first.up_right;
+      traps[top].down_left = cur_l;
+      traps[top].down_right = cur_r;
+      for (int32_t u : { first.up_left, first.up_right })
+        if (u != -1) {
+          if (traps[u].down_left == crossed[0])
+            traps[u].down_left = top;
+          if (traps[u].down_right == crossed[0])
+            traps[u].down_right = top;
+        }
+      traps[cur_l].up_left = top;
+      traps[cur_r].up_right = top;
+    } else {
+      traps[cur_l].up_left = first.up_left;
+      if (first.up_left != -1)
+        traps[first.up_left].down_left = cur_l;
+      traps[cur_r].up_right = first.up_right;
+      if (first.up_right != -1)
+        traps[first.up_right].down_right = cur_r;
+    }
+    left_part[0] = cur_l;
+    right_part[0] = cur_r;
+
+    // every vertex between two crossed trapezoids cuts off the piece on its
+    // own side of s, and the piece on the other side goes on
+    for (size_t j = 0; j < k; j++) {
+      trapezoid d = traps[crossed[j]], below = traps[crossed[j + 1]];
+      int32_t b = d.bottom;
+      if (left_of(s, b)) {
+        traps[cur_l].bottom = b;
+        traps[cur_l].down_left = d.down_left;
+        if (d.down_left != -1)
+          traps[d.down_left].up_left = cur_l;
+        int32_t piece = add_trapezoid(below.left, s, b, -1);
+        traps[cur_l].down_right = piece;
+        traps[piece].up_right = cur_l;
+        traps[piece].up_left = below.up_left;
+        if (below.up_left != -1)
+          traps[below.up_left].down_left = piece;
+        cur_l = piece;
+      } else {
+        traps[cur_r].bottom = b;
+        traps[cur_r].down_right = d.down_right;
+        if (d.down_right != -1)
+          traps[d.down_right].up_right = cur_r;
+        int32_t piece = add_trapezoid(s, below.right, b, -1);
+        traps[cur_r].down_left = piece;
+        traps[piece].up_left = cur_r;
+        traps[piece].up_right = below.up_right;
+        if (below.up_right != -1)
+          traps[below.up_right].down_right = piece;
+        cur_r = piece;
+      }
+      left_part[j + 1] = cur_l;
+      right_part[j + 1] = cur_r;
+    }
+
+    // and the bottom of the last one, cut off level with q
+    trapezoid last = traps[crossed[k]];
+    traps[cur_l].bottom = traps[cur_r].bottom = q;
+    int32_t bottom = -1;
+    if (q_new) {
+      bottom = add_trapezoid(last.left, last.right, q, last.bottom);
+      traps[bottom].down_left = last.down_left;
+      traps[bottom].down_right = last.down_right;
+      traps[bottom].up_left = cur_l;
+      traps[bottom].up_right = cur_r;
+      for (int32_t u : { last.down_left, last.down_right })
+        if (u != -1) {
+          if (traps[u].up_left == crossed[k])
+            traps[u].up_left = bottom;
+          if (traps[u].up_right == crossed[k])
+            traps[u].up_right = bottom;
+        }
+      traps[cur_l].down_left = bottom;
+      traps[cur_r].down_right = bottom;
+    } else {
+      traps[cur_l].down_left = last.down_left;
+      if (last.down_left != -1)
+        traps[last.down_left].up_left = cur_l;
+      traps[cur_r].down_right = last.down_right;
+      if (last.down_right != -1)
+        traps[last.down_right].up_right = cur_r;
+    }
+
+    // the sinks of the crossed trapezoids become the nodes that tell the new
+    // ones apart
+    for (size_t j = 0; j <= k; j++) {
+      int32_t node = sinks[crossed[j]];
+      trapezoid_node split = { x_node, (int32_t)s, sinks[left_part[j]]
+        , sinks[right_part[j]] };
+      bool cut_top = j == 0 && p_new, cut_bottom = j == k && q_new;
+      if (!cut_top && !cut_bottom) {
+        nodes[node] = split;
+        continue;
+      }
+      nodes.push_back(split);
+      int32_t inner = nodes.size() - 1;
+      if (cut_top && cut_bottom) {
+        nodes.push_back({ y_node, (int32_t)q, inner, sinks[bottom] });
+        inner = nodes.size() - 1;
+      }
+      if (cut_top)
+        nodes[node] = { y_node, (int32_t)p, sinks[top], inner };
+      else
+        nodes[node] = { y_node, (int32_t)q, inner, sinks[bottom] };
+    }
+  }
+};
+
+// log* n, the number of times log2 has to be applied to n to get below 1
+static size_t log_star(size_t n) {
+  size_t h = 0;
+  for (double v = n; v >= 1; v = std::log2(v))
+    h++;
+  return h - 1;
+}
+
+// number of edges added by the end of phase h
+static size_t phase_end(size_t n, size_t h) {
+  double v = n;
+  for (size_t i = 0; i < h; i++)
+    v = std::log2(v);
+  return std::min(n, (size_t)std::ceil(n / v));
+}
+
+template <typename T>
+trapezoid_map<T>::trapezoid_map(const vec2<T> *n_vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes)
+  : vertices(n_vertices)
+  , reversed(signed_area(n_vertices, holes == 0 ? n : hole_starts[0]) < 0) {
+  polygon_rings rings(n, hole_starts, holes);
+  next = rings.next;
+  trapezoid_builder<T> b;
+  b.map = this;
+  b.vertices = vertices;
+  b.next = next.data();
+  b.inserted.assign(n, 0);
+  b.start.assign(n, 0);
+  b.add_trapezoid(-1, -1, -1, -1);
+
+  // a fixed seed, so that the same polygon comes out the same every time
+  std::vector<uint32_t> order(n);
+  for (size_t i = 0; i < n; i++)
+    order[i] = i;
+  std::mt19937 random(n);
+  std::shuffle(order.begin(), order.end(), random);
+  size_t added = 0, phases = n < 2 ? 0 : log_star(n);
+  for (size_t h = 1; h <= phases; h++) {
+    for (size_t end = phase_end(n, h); added < end; added++)
+      b.insert(order[added]);
+    for (size_t i = added; i < n; i++) {
+      uint32_t e = order[i];
+      b.start[e] = b.locate(b.upper(e), b.lower(e), b.start[e]);
+    }
+  }
+  for (; added < n; added++)
+    b.insert(order[added]);
+
+  // lay the search structure out depth first, so that the nodes a query
+  // visits near the bottom tend to share cache lines, and keep the
+  // trapezoids that weren't split on the way in the order their leaves come
+  std::vector<int32_t> placed(nodes.size(), -1), live(trapezoids.size(), -1)
+    , stack(1, 0);
+  std::vector<trapezoid_node> laid;
+  std::vector<trapezoid> kept;
+  laid.reserve(nodes.size());
+  while (!stack.empty()) {
+    int32_t i = stack.back();
+    stack.pop_back();
+    if (placed[i] != -1)
+      continue;
+    placed[i] = laid.size();
+    laid.push_back(nodes[i]);
+    if (nodes[i].kind == sink_node) {
+      live[nodes[i].key] = kept.size();
+      kept.push_back(trapezoids[nodes[i].key]);
+    } else {
+      stack.push_back(nodes[i].second);
+      stack.push_back(nodes[i].first);
+    }
+  }
+  for (trapezoid_node &d : laid)
+    if (d.kind == sink_node)
+      d.key = live[d.key];
+    else {
+      d.first = placed[d.first];
+      d.second = placed[d.second];
+    }
+  for (trapezoid &t : kept)
+    for (int32_t *link : { &t.up_left, &t.up_right, &t.down_left
+        , &t.down_right })
+      if (*link != -1)
+        *link = live[*link];
+  nodes.swap(laid);
+  trapezoids.swap(kept);
+}
+
+template <typename T>
+int32_t trapezoid_map<T>::locate(const vec2<T> &p) const {
+  int32_t node = 0;
+  while (nodes[node].kind != sink_node) {
+    const trapezoid_node &d = nodes[node];
+    if (d.kind == y_node)
+      node = above(p, vertices[d.key]) ? d.first : d.second;
+    else {
+      const vec2<T> &a = vertices[d.key], &b = vertices[next[d.key]];
+      bool up = above(b, a);
+      node = (up ? orient(a, b, p) : orient(b, a, p)) > 0 ? d.first
+        : d.second;
+    }
+  }
+  return nodes[node].key;
+}
+
+template <typename T>
+bool trapezoid_map<T>::inside(int32_t t) const {
+  const trapezoid &z = trapezoids[t];
+  // the interior is left of every edge, so the right edge has to go up, or
+  // down when the rings wind the other way
+  return z.left != -1 && z.right != -1
+    && above(vertices[next[z.right]], vertices[z.right]) != reversed;
+}
+
+template struct trapezoid_map<float>;
+template struct trapezoid_map<double>;
+template struct trapezoid_map<int32_t>;
+
+// a trapezoid whose top and bottom vertex aren't on the same edge gets a
+// diagonal between them, which leaves y-monotone pieces
+template <typename T>
+void seidel_triangulate(const vec2<T> *vertices, const polygon_rings &rings
+    , index_sink *out) {
+  trapezoid_map<T> map(vertices, rings.n, rings.holes.data()
+      , rings.holes.size());
+  std::vector<diagonal> diagonals;
+  auto on = [&](int32_t e, int32_t v) {
+    return e == v || (int32_t)map.next[e] == v;
+  };
+  for (size_t t = 0; t < map.trapezoids.size(); t++) {
+    const trapezoid &z = map.trapezoids[t];
+    if (!map.inside(t) || z.top == -1 || z.bottom == -1)
+      continue;
+    if ((on(z.left, z.top) && on(z.left, z.bottom))
+        || (on(z.right, z.top) && on(z.right, z.bottom)))
+      continue;
+    diagonals.push_back({ (uint32_t)z.top, (uint32_t)z.bottom });
+  }
+  triangulate_monotone_pieces(vertices, rings, diagonals, out);
+}
+
+template void seidel_triangulate(const vec2<float> *vertices
+    , const polygon_rings &rings, index_sink *out);
+template void seidel_triangulate(const vec2<double> *vertices
+    , const polygon_rings &rings, index_sink *out);
+template void seidel_triangulate(const vec2<int32_t> *vertices
+    , const polygon_rings &rings, index_sink *out);
@@ -0,0 +1,21 @@
+#pragma once
+
+// the vector kernels are compiled for avx2 and sse2 with per-function target
+// attributes and picked at runtime, so the library itself builds for the
+// baseline instruction set
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+inline bool cpu_has_avx2() {
+#ifdef SIMD_X86
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
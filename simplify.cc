@@ -0,0 +1,312 @@
+#include "triangulators.hh"
+#include <algorithm>
+
+// the clean-up comes in two steps. the first takes out every vertex that
+// coincides with the next one or lies on the line through its neighbours,
+// which doesn't change the polygon at all. it works off a stack, since taking
+// a vertex out can leave either of its neighbours collinear in turn. the
+// second is douglas-peucker on every ring: a run of vertices is replaced by
+// the chord between its ends as long as none of them is further than the
+// tolerance from it, and split at the one furthest away otherwise. on top of
+// that a chord is only taken if the loop it closes with its run winds around
+// no other vertex of any ring. since the runs don't cross each other, no two
+// chords that pass this can cross either: a chord crossing another one has to
+// cross the other one's run as well, and then one of the edges of that run
+// would have to start inside the other one's loop. so the simplified rings
+// are as simple as the input, and holes stay on the side of the boundary they
+// were. the vertices it looks at are found through a uniform grid
+
+// takes the vertices out of `ring`, original indices going around one ring,
+// that are the same as the next one or collinear with their neighbours.
+// clears it if fewer than three are left
+template <typename T>
+static void drop_collinear(const vec2<T> *vertices
+    , std::vector<uint32_t> *ring) {
+  std::vector<uint32_t> &r = *ring;
+  uint32_t m = r.size();
+  std::vector<uint32_t> next(m), prev(m), stack(m);
+  std::vector<uint8_t> gone(m, 0);
+  for (uint32_t i = 0; i < m; i++) {
+    next[i] = (i + 1) % m;
+    prev[i] = (i + m - 1) % m;
+    stack[i] = m - 1 - i;
+  }
+  uint32_t left = m;
+  while (!stack.empty() && left >= 3) {
+    uint32_t i = stack.back();
+    stack.pop_back();
+    if (gone[i])
+      continue;
+    const vec2<T> &a = vertices[r[prev[i]]], &b = vertices[r[i]]
+      , &c = vertices[r[next[i]]];
+    if (!(b.x == c.x && b.y == c.y) && orient(a, b, c) != 0)
+      continue;
+    gone[i] = 1;
+    left--;
+    next[prev[i]] = next[i];
+    prev[next[i]] = prev[i];
+    stack.push_back(prev[i]);
+    stack.push_back(next[i]);
+  }
+  if (left < 3) {
+    r.clear();
+    return;
+  }
+  size_t kept = 0;
+  for (uint32_t i = 0; i < m; i++)
+    if (!gone[i])
+      r[kept++] = r[i];
+  r.resize(kept);
+}
+
+template <typename T>
+static double distance2_to_segment(const vec2<T> &p, const vec2<T> &a
+    , const vec2<T> &b) {
+  double px = (double)p.x, py = (double)p.y, ax = (double)a.x
+    , ay = (double)a.y, bx = (double)b.x, by = (double)b.y, dx = bx - ax
+    , dy = by - ay, length2 = dx * dx + dy * dy
+    , s = length2 > 0 ? ((px - ax) * dx + (py - ay) * dy) / length2 : 0;
+  s = std::min(std::max(s, 0.), 1.);
+  double x = ax + s * dx - px, y = ay + s * dy - py;
+  return x * x + y * y;
+}
+
+template <typename T>
+struct simplifier
+{
+  const vec2<T> *vertices;
+  // the rings left after drop_collinear(), all in one array, ring k from
+  // ring_first[k] up to ring_first[k + 1]
+  std::vector<uint32_t> flat, ring_first, ring_of;
+  // every vertex of `flat` by the grid cell it falls in, cell c holding the
+  // ones from cell_first[c] up to cell_first[c + 1]
+  double min_x, min_y, cell;
+  size_t columns, rows;
+  std::vector<uint32_t> cell_first, in_cells;
+
+  const vec2<T> &at(size_t k, size_t position) const {
+    size_t size = ring_first[k + 1] - ring_first[k];
+    return vertices[flat[ring_first[k] + position % size]];
+  }
+  size_t column(double x) const {
+    return std::min((size_t)((x - min_x) / cell), columns - 1);
+  }
+  size_t row(double y) const {
+    return std::min((size_t)((y - min_y) / cell), rows - 1);
+  }
+  void build_grid();
+  bool encloses(size_t k, size_t a, size_t b, const vec2<T> &q) const;
+  bool conflicts(size_t k, size_t a, size_t b, double deviation2) const;
+  void simplify_ring(size_t k, double tolerance2, std::vector<uint8_t> *keep)
+    const;
+};
+
+template <typename T>
+void simplifier<T>::build_grid() {
+  size_t m = flat.size();
+  double max_x, max_y;
+  min_x = max_x = (double)vertices[flat[0]].x;
+  min_y = max_y = (double)vertices[flat[0]].y;
+  for (uint32_t v : flat) {
+    min_x = std::min(min_x, (double)vertices[v].x);
+    max_x = std::max(max_x, (double)vertices[v].x);
+    min_y = std::min(min_y, (double)vertices[v].y);
+    max_y = std::max(max_y, (double)vertices[v].y);
+  }
+  // about one vertex per cell, without ever having more cells than 3m + 1
+  // however flat the box
+  double w = max_x - min_x, h = max_y - min_y;
+  cell = std::max(std::sqrt(w * h / (double)m), std::max(w, h) / (double)m);
+  if (cell == 0)
+    cell = 1;
+  columns = (size_t)(w / cell) + 1;
+  rows = (size_t)(h / cell) + 1;
+  cell_first.assign(columns * rows + 1, 0);
+  std::vector<uint32_t> cell_of(m);
+  for (size_t g = 0; g < m; g++) {
+    const vec2<T> &p = vertices[flat[g]];
+    cell_of[g] = row((double)p.y) * columns + column((double)p.x);
+    cell_first[cell_of[g] + 1]++;
+  }
+  for (size_t c = 0; c < columns * rows; c++)
+    cell_first[c + 1] += cell_first[c];
+  std::vector<uint32_t> fill(cell_first.begin(), cell_first.end() - 1);
+  in_cells.resize(m);
+  for (size_t g = 0; g < m; g++)
+    in_cells[fill[cell_of[g]]++] = g;
+}
+
+// whether the loop the run from a to b of ring k makes with the chord between
+// its ends winds around q, or passes through it
+template <typename T>
+bool simplifier<T>::encloses(size_t k, size_t a, size_t b, const vec2<T> &q)
+    const {
+  int winding = 0;
+  for (size_t i = a; i <= b; i++) {
+    const vec2<T> &u = at(k, i), &v = at(k, i == b ? a : i + 1);
+    auto side = orient(u, v, q);
+    if (side == 0 && std::min(u.x, v.x) <= q.x && q.x <= std::max(u.x, v.x)
+        && std::min(u.y, v.y) <= q.y && q.y <= std::max(u.y, v.y))
+      return true;
+    if (u.y <= q.y) {
+      if (v.y > q.y && side > 0)
+        winding++;
+    } else if (v.y <= q.y && side < 0)
+      winding--;
+  }
+  return winding != 0;
+}
+
+// whether the chord from a to b of ring k, whose run stays within
+// sqrt(deviation2) of it, can't stand in for the run
+template <typename T>
+bool simplifier<T>::conflicts(size_t k, size_t a, size_t b
+    , double deviation2) const {
+  // all of the loop lies in the convex hull of the run, so the vertices
+  // to look at are within the deviation of the chord and inside the box
+  // around the run
+  const vec2<T> &pa = at(k, a), &pb = at(k, b);
+  double left = (double)pa.x, right = left, bottom = (double)pa.y
+    , top = bottom;
+  for (size_t i = a + 1; i <= b; i++) {
+    const vec2<T> &p = at(k, i);
+    left = std::min(left, (double)p.x), right = std::max(right, (double)p.x);
+    bottom = std::min(bottom, (double)p.y), top = std::max(top, (double)p.y);
+  }
+  size_t size = ring_first[k + 1] - ring_first[k];
+  for (size_t y = row(bottom), y_end = row(top); y <= y_end; y++)
+    for (size_t x = column(left), x_end = column(right); x <= x_end; x++) {
+      size_t c = y * columns + x;
+      for (uint32_t j = cell_first[c]; j < cell_first[c + 1]; j++) {
+        uint32_t g = in_cells[j];
+        size_t position = g - ring_first[ring_of[g]];
+        if (ring_of[g] == k && ((a <= position && position <= b)
+              || position == b % size))
+          continue;
+        const vec2<T> &q = vertices[flat[g]];
+        if ((double)q.x < left || (double)q.x > right
+            || (double)q.y < bottom || (double)q.y > top
+            || distance2_to_segment(q, pa, pb)
+              > deviation2)
+          continue;
+        if (encloses(k, a, b, q))
+          return true;
+      }
+    }
+  return false;
+}
+
+// marks the vertices of ring k douglas-peucker keeps. the ring is split at
+// its first vertex and the one furthest from it, and position `size` stands
+// for the first vertex again
+template <typename T>
+void simplifier<T>::simplify_ring(size_t k, double tolerance2
+    , std::vector<uint8_t> *keep) const {
+  size_t size = ring_first[k + 1] - ring_first[k], far = 0;
+  double far2 = 0;
+  for (size_t i = 1; i < size; i++) {
+    double dx = (double)at(k, i).x - (double)at(k, 0).x
+      , dy = (double)at(k, i).y - (double)at(k, 0).y;
+    if (dx * dx + dy * dy > far2)
+      far2 = dx * dx + dy * dy, far = i;
+  }
+  uint8_t *kept = keep->data() + ring_first[k];
+  kept[0] = kept[far] = 1;
+  std::vector<std::pair<size_t, size_t>> stack = { { 0, far }, { far, size } };
+  // the run the chords came out of with the furthest vertex from them, in
+  // case the ring comes out with only two vertices
+  size_t widest = 0, widest_a = 0, widest_b = 0;
+  double widest2 = -1;
+  auto furthest = [&](size_t a, size_t b, double *deviation2) {
+    const vec2<T> &pa = at(k, a), &pb = at(k, b);
+    size_t split = a + 1;
+    *deviation2 = -1;
+    for (size_t i = a + 1; i < b; i++) {
+      const vec2<T> &p = at(k, i);
+      double d2 = distance2_to_segment(p, pa, pb);
+      if (d2 > *deviation2)
+        *deviation2 = d2, split = i;
+    }
+    return split;
+  };
+  for (int round = 0; round < 2; round++) {
+    while (!stack.empty()) {
+      size_t a = stack.back().first, b = stack.back().second;
+      stack.pop_back();
+      if (b - a < 2)
+        continue;
+      double deviation2;
+      size_t split = furthest(a, b, &deviation2);
+      if (deviation2 > tolerance2 || conflicts(k, a, b, deviation2)) {
+        kept[split] = 1;
+        stack.push_back({ a, split });
+        stack.push_back({ split, b });
+      } else if (deviation2 > widest2)
+        widest2 = deviation2, widest = split, widest_a = a, widest_b = b;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < size; i++)
+      count += kept[i];
+    if (count >= 3)
+      break;
+    kept[widest] = 1;
+    stack.push_back({ widest_a, widest });
+    stack.push_back({ widest, widest_b });
+  }
+}
+
+template <typename T>
+size_t simplify(const vec2<T> *vertices, size_t n, const uint32_t *hole_starts
+    , size_t holes, double tolerance, std::vector<uint32_t> *kept
+    , std::vector<uint32_t> *kept_hole_starts) {
+  kept->clear();
+  if (kept_hole_starts)
+    kept_hole_starts->clear();
+  simplifier<T> s;
+  s.vertices = vertices;
+  s.ring_first.push_back(0);
+  for (size_t k = 0; k <= holes; k++) {
+    uint32_t begin = k == 0 ? 0 : hole_starts[k - 1]
+      , end = k == holes ? n : hole_starts[k];
+    std::vector<uint32_t> ring(end - begin);
+    for (uint32_t v = begin; v < end; v++)
+      ring[v - begin] = v;
+    drop_collinear(vertices, &ring);
+    // nothing is left of the polygon without its outer ring, and holes that
+    // were nothing but a line go altogether
+    if (ring.empty() && k == 0)
+      return 0;
+    if (ring.empty())
+      continue;
+    s.flat.insert(s.flat.end(), ring.begin(), ring.end());
+    s.ring_first.push_back(s.flat.size());
+  }
+  size_t rings = s.ring_first.size() - 1;
+  std::vector<uint8_t> keep(s.flat.size(), 1);
+  if (tolerance > 0) {
+    for (size_t k = 0; k < rings; k++)
+      s.ring_of.insert(s.ring_of.end(), s.ring_first[k + 1] - s.ring_first[k]
+          , k);
+    s.build_grid();
+    std::fill(keep.begin(), keep.end(), 0);
+    for (size_t k = 0; k < rings; k++)
+      s.simplify_ring(k, tolerance * tolerance, &keep);
+  }
+  for (size_t k = 0; k < rings; k++) {
+    if (k > 0 && kept_hole_starts)
+      kept_hole_starts->push_back(kept->size());
+    for (uint32_t g = s.ring_first[k]; g < s.ring_first[k + 1]; g++)
+      if (keep[g])
+        kept->push_back(s.flat[g]);
+  }
+  return kept->size();
+}
+
+#define INSTANTIATE(T) \
+  template size_t simplify(const vec2<T> *vertices, size_t n \
+      , const uint32_t *hole_starts, size_t holes, double tolerance \
+      , std::vector<uint32_t> *kept, std::vector<uint32_t> *kept_hole_starts);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
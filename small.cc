@@ -0,0 +1,177 @@
+#include "triangulators.hh"
+#include "simd.hh"
+#include <algorithm>
+
+// a simple polygon of up to six vertices has few enough triangulations to try
+// them all: two for a quad, five for a pentagon and fourteen for a hexagon.
+// one of them is valid exactly when all of its triangles wind ccw, since then
+// they cover the inside of the boundary once and the outside not at all. the
+// orientation of every triple of vertices is computed for eight polygons at
+// a time, each candidate is checked against them with a few masks, and the
+// first one that holds is picked per lane without a single branch.
+//
+// the vector test is done in single precision and only trusts an orientation
+// that is clear of its rounding error, with the bound from shewchuk's
+// orient2d filter. polygons that no candidate is clearly valid for, which
+// are either degenerate or not simple, go through triangulate() one by one
+
+static const size_t small_max = 6;
+
+struct small_table
+{
+  size_t triples, candidates;
+  // vertices of every triple, and which triple every corner triple is
+  uint8_t triple[20][3], triple_of[small_max][small_max][small_max];
+  // the triangles of every candidate as triples
+  uint8_t candidate[14][small_max - 2];
+};
+
+// every triangulation of the convex polygon [first, last] as a list of
+// triangles
+static void triangulations(size_t first, size_t last
+    , std::vector<std::vector<uint8_t>> *out, const small_table &t) {
+  out->clear();
+  if (last - first < 2) {
+    out->push_back({});
+    return;
+  }
+  std::vector<std::vector<uint8_t>> left, right;
+  for (size_t m = first + 1; m < last; m++) {
+    triangulations(first, m, &left, t);
+    triangulations(m, last, &right, t);
+    for (const std::vector<uint8_t> &l : left)
+      for (const std::vector<uint8_t> &r : right) {
+        out->push_back(l);
+        out->back().insert(out->back().end(), r.begin(), r.end());
+        out->back().push_back(t.triple_of[first][m][last]);
+      }
+  }
+}
+
+static small_table make_small_table(size_t n) {
+  small_table t;
+  t.triples = 0;
+  for (size_t a = 0; a < n; a++)
+    for (size_t b = a + 1; b < n; b++)
+      for (size_t c = b + 1; c < n; c++) {
+        t.triple[t.triples][0] = a;
+        t.triple[t.triples][1] = b;
+        t.triple[t.triples][2] = c;
+        t.triple_of[a][b][c] = t.triples++;
+      }
+  std::vector<std::vector<uint8_t>> all;
+  triangulations(0, n - 1, &all, t);
+  t.candidates = all.size();
+  for (size_t k = 0; k < all.size(); k++)
+    std::copy(all[k].begin(), all[k].end(), t.candidate[k]);
+  return t;
+}
+
+static const small_table &small_tables(size_t n) {
+  static const small_table tables[] = { make_small_table(3)
+    , make_small_table(4), make_small_table(5), make_small_table(6) };
+  return tables[n - 3];
+}
+
+// the first candidate whose triangles all wind ccw, or -1
+static int32_t pick_small(const vertex *v, const small_table &t, size_t n) {
+  for (size_t k = 0; k < t.candidates; k++) {
+    size_t i = 0;
+    for (; i < n - 2; i++) {
+      const uint8_t *c = t.triple[t.candidate[k][i]];
+      if (orient(v[c[0]], v[c[1]], v[c[2]]) <= 0)
+        break;
+    }
+    if (i == n - 2)
+      return k;
+  }
+  return -1;
+}
+
+#ifdef SIMD_X86
+// picks the candidates for the eight polygons starting at `v`
+TARGET_AVX2
+static void pick_small_avx2(const vertex *v, const small_table &t, size_t n
+    , int32_t *picked) {
+  const float *base = &v->x;
+  const __m256i stride = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+      , _mm256_set1_epi32(2 * n));
+  __m256 x[small_max], y[small_max];
+  for (size_t j = 0; j < n; j++) {
+    x[j] = _mm256_i32gather_ps(base + 2 * j, stride, 4);
+    y[j] = _mm256_i32gather_ps(base + 2 * j + 1, stride, 4);
+  }
+  const __m256 bound = _mm256_set1_ps(1.8e-7f)
+    , abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  __m256 ccw[20];
+  for (size_t k = 0; k < t.triples; k++) {
+    size_t a = t.triple[k][0], b = t.triple[k][1], c = t.triple[k][2];
+    __m256 left = _mm256_mul_ps(_mm256_sub_ps(x[b], x[a])
+        , _mm256_sub_ps(y[c], y[a]))
+      , right = _mm256_mul_ps(_mm256_sub_ps(y[b], y[a])
+          , _mm256_sub_ps(x[c], x[a]))
+      , det = _mm256_sub_ps(left, right)
+      , error = _mm256_mul_ps(bound, _mm256_add_ps(_mm256_and_ps(left, abs)
+            , _mm256_and_ps(right, abs)));
+    ccw[k] = _mm256_cmp_ps(det, error, _CMP_GT_OQ);
+  }
+  __m256i pick = _mm256_set1_epi32(-1);
+  for (size_t k = t.candidates; k-- > 0; ) {
+    __m256 valid = ccw[t.candidate[k][0]];
+    for (size_t i = 1; i < n - 2; i++)
+      valid = _mm256_and_ps(valid, ccw[t.candidate[k][i]]);
+    pick = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(pick)
+          , _mm256_castsi256_ps(_mm256_set1_epi32(k)), valid));
+  }
+  _mm256_storeu_si256((__m256i*)picked, pick);
+}
+#endif
+
+size_t triangulate_small(const vertex *vertices, size_t n, size_t count
+    , uint32_t *indices) {
+  size_t m = max_triangles(n);
+  if (m == 0)
+    return 0;
+  auto fallback = [&](size_t k) {
+    uint32_t *tri = indices + 3 * m * k, first = k * n;
+    index_sink out(tri, nullptr, m);
+    triangulate_polygon(vertices + first, n, nullptr, 0, EarClipping, &out);
+    for (size_t i = 0; i < 3 * out.count; i++)
+      tri[i] += first;
+    for (size_t i = 3 * out.count; i < 3 * m; i++)
+      tri[i] = first;
+  };
+  if (n > small_max) {
+    for (size_t k = 0; k < count; k++)
+      fallback(k);
+    return m * count;
+  }
+  const small_table &t = small_tables(n);
+  auto emit = [&](size_t k, int32_t picked) {
+    if (picked < 0) {
+      fallback(k);
+      return;
+    }
+    uint32_t *tri = indices + 3 * m * k, first = k * n;
+    for (size_t i = 0; i < m; i++) {
+      const uint8_t *c = t.triple[t.candidate[picked][i]];
+      tri[3 * i] = first + c[0];
+      tri[3 * i + 1] = first + c[1];
+      tri[3 * i + 2] = first + c[2];
+    }
+  };
+  size_t k = 0;
+#ifdef SIMD_X86
+  static const bool avx2 = cpu_has_avx2();
+  if (avx2)
+    for (int32_t picked[8]; k + 8 <= count; k += 8) {
+      pick_small_avx2(vertices + k * n, t, n, picked);
+      for (size_t lane = 0; lane < 8; lane++)
+        emit(k + lane, picked[lane]);
+    }
+#endif
+  for (; k < count; k++)
+    emit(k, pick_small(vertices + k * n, t, n));
+  return m * count;
+}
@@ -0,0 +1,122 @@
+#include "triangulators.hh"
+#include <algorithm>
+#include <thread>
+
+// every triangle gets the position of its centroid along the curve, with the
+// centroids snapped to a 2^16 by 2^16 grid over their bounding box, and the
+// triangles are sorted by it with an lsd radix sort, a byte at a time. every
+// thread counts the digits of its own run of triangles, the counts of all of
+// them together give every thread where its share of every digit goes, and
+// the threads scatter their runs there, which keeps the sort stable. passes
+// whose digit is the same for every triangle are skipped
+
+static const size_t radix = 256;
+
+// below this many triangles one thread does it all
+static const size_t parallel_triangles = 1 << 16;
+
+// calls `work` with every worker in [0, workers), from as many threads
+// including the calling one
+template <typename F>
+static void run_workers(unsigned workers, F work) {
+  std::vector<std::thread> threads;
+  for (unsigned w = 1; w < workers; w++)
+    threads.emplace_back(work, w);
+  work(0);
+  for (std::thread &t : threads)
+    t.join();
+}
+
+template <typename T>
+void sort_spatially(vec2<T> *vertices, size_t n, uint32_t *indices
+    , int32_t *neighbors, size_t triangles, int curve, uint32_t *remap
+    , unsigned threads) {
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  unsigned workers = triangles < parallel_triangles ? 1
+    : (unsigned)std::min<size_t>(threads, triangles / (parallel_triangles / 4));
+  auto run_of = [&](unsigned w, size_t *begin, size_t *end) {
+    *begin = triangles * w / workers;
+    *end = triangles * (w + 1) / workers;
+  };
+
+  // three times the centroids, which orders them all the same
+  double min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+  if (triangles != 0) {
+    min_x = max_x = vertices[indices[0]].x;
+    min_y = max_y = vertices[indices[0]].y;
+  }
+  for (size_t i = 0; i < 3 * triangles; i++) {
+    const vec2<T> &v = vertices[indices[i]];
+    min_x = std::min(min_x, (double)v.x), max_x = std::max(max_x, (double)v.x);
+    min_y = std::min(min_y, (double)v.y), max_y = std::max(max_y, (double)v.y);
+  }
+  double scale_x = max_x > min_x ? 0xffff / (3 * (max_x - min_x)) : 0
+    , scale_y = max_y > min_y ? 0xffff / (3 * (max_y - min_y)) : 0;
+  std::vector<uint32_t> keys(triangles), order(triangles)
+    , next_keys(triangles), next_order(triangles);
+  run_workers(workers, [&](unsigned w) {
+        size_t begin, end;
+        run_of(w, &begin, &end);
+        for (size_t t = begin; t < end; t++) {
+          const uint32_t *c = indices + 3 * t;
+          double x = 0, y = 0;
+          for (int k = 0; k < 3; k++)
+            x += (double)vertices[c[k]].x, y += (double)vertices[c[k]].y;
+          uint32_t qx = std::min((x - 3 * min_x) * scale_x, 65535.)
+            , qy = std::min((y - 3 * min_y) * scale_y, 65535.);
+          keys[t] = curve == Hilbert ? hilbert(qx, qy) : morton(qx, qy);
+          order[t] = t;
+        }
+      });
+
+  std::vector<size_t> counts(workers * radix);
+  for (int shift = 0; shift < 32; shift += 8) {
+    std::fill(counts.begin(), counts.end(), 0);
+    run_workers(workers, [&](unsigned w) {
+          size_t begin, end, *count = &counts[w * radix];
+          run_of(w, &begin, &end);
+          for (size_t i = begin; i < end; i++)
+            count[(keys[i] >> shift) & (radix - 1)]++;
+        });
+    // where every worker's share of every digit starts, digit by digit and
+    // within a digit worker by worker
+    size_t at = 0;
+    bool uniform = false;
+    for (size_t d = 0; d < radix; d++) {
+      size_t first = at;
+      for (unsigned w = 0; w < workers; w++) {
+        size_t c = counts[w * radix + d];
+        counts[w * radix + d] = at;
+        at += c;
+      }
+      uniform = uniform || at - first == triangles;
+    }
+    if (uniform)
+      continue;
+    run_workers(workers, [&](unsigned w) {
+          size_t begin, end, *offset = &counts[w * radix];
+          run_of(w, &begin, &end);
+          for (size_t i = begin; i < end; i++) {
+            size_t &o = offset[(keys[i] >> shift) & (radix - 1)];
+            next_keys[o] = keys[i];
+            next_order[o] = order[i];
+            o++;
+          }
+        });
+    keys.swap(next_keys);
+    order.swap(next_order);
+  }
+
+  reorder_triangles(indices, neighbors, triangles, order);
+  optimize_vertex_fetch(vertices, n, indices, triangles, remap);
+}
+
+#define INSTANTIATE(T) \
+  template void sort_spatially(vec2<T> *vertices, size_t n, uint32_t *indices \
+      , int32_t *neighbors, size_t triangles, int curve, uint32_t *remap \
+      , unsigned threads);
+INSTANTIATE(float)
+INSTANTIATE(double)
+INSTANTIATE(int32_t)
+#undef INSTANTIATE
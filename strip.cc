@@ -0,0 +1,114 @@
+#include "poly2tri.hh"
+#include <algorithm>
+
+// greedy stripification over the neighbours. a strip goes on across the edge
+// between its last two vertices for free, and across the other one left for
+// a repeated vertex, so what matters most is where a strip starts and which
+// way it sets out. starting from a triangle with as few neighbours left as
+// any keeps the ones at the edges of what's been stripped from being cut off
+// on their own. triangles are kept in buckets by how many of their
+// neighbours aren't in a strip yet, and entries that have gone out of date
+// are skipped when they come up
+
+// the edge of triangle t that joins vertices a and b
+static int edge_of(const uint32_t *indices, int32_t t, uint32_t a, uint32_t b) {
+  const uint32_t *c = indices + 3 * t;
+  for (int k = 0; k < 3; k++)
+    if ((c[k] == a && c[(k + 1) % 3] == b)
+        || (c[k] == b && c[(k + 1) % 3] == a))
+      return k;
+  return -1;
+}
+
+size_t stripify(const uint32_t *indices, const int32_t *neighbors
+    , size_t triangles, bool restart, std::vector<uint32_t> *strip) {
+  strip->clear();
+  std::vector<uint8_t> left(triangles), taken(triangles, 0);
+  std::vector<int32_t> buckets[4];
+  for (size_t t = 0; t < triangles; t++) {
+    for (int k = 0; k < 3; k++)
+      left[t] += neighbors[3 * t + k] != -1;
+    buckets[left[t]].push_back(t);
+  }
+  auto take = [&](int32_t t) {
+    taken[t] = 1;
+    for (int k = 0; k < 3; k++) {
+      int32_t u = neighbors[3 * t + k];
+      if (u != -1 && !taken[u])
+        buckets[--left[u]].push_back(u);
+    }
+  };
+  auto next_start = [&]() -> int32_t {
+    for (std::vector<int32_t> &bucket : buckets)
+      while (!bucket.empty()) {
+        int32_t t = bucket.back();
+        bucket.pop_back();
+        if (!taken[t] && &bucket == &buckets[left[t]])
+          return t;
+      }
+    return -1;
+  };
+
+  for (int32_t t; (t = next_start()) != -1; ) {
+    // sets out towards the neighbour with the fewest neighbours left itself
+    const uint32_t *c = indices + 3 * t;
+    int out = -1;
+    for (int k = 0; k < 3; k++) {
+      int32_t u = neighbors[3 * t + k];
+      if (u != -1 && !taken[u] && (out == -1
+            || left[u] < left[neighbors[3 * t + out]]))
+        out = k;
+    }
+    // the first triangle is abd with bd the edge out, so it starts with the
+    // corner across from that
+    int first = out == -1 ? 0 : (out + 2) % 3;
+    uint32_t a = c[first], b = c[(first + 1) % 3], d = c[(first + 2) % 3];
+
+    // strips are drawn in turn as one, so every strip has to start on an
+    // even position to keep its winding. degenerate triangles join them up,
+    // repeating the last vertex of one and the first of the next
+    if (!strip->empty()) {
+      if (restart)
+        strip->push_back(strip_restart);
+      else {
+        uint32_t last = strip->back();
+        strip->push_back(last);
+        strip->push_back(a);
+        if (strip->size() % 2)
+          strip->push_back(a);
+      }
+    }
+    strip->push_back(a);
+    strip->push_back(b);
+    strip->push_back(d);
+    take(t);
+    // every next triangle lies across the edge between the last two
+    // vertices, bd, and adds its third corner. the strip can also turn
+    // across ad for the price of one more index: repeating a before d draws
+    // abd as bad, whose last two vertices are ad. it does when bd is closed,
+    // or when the triangle across ad has fewer ways on left
+    for (;;) {
+      int32_t u = neighbors[3 * t + edge_of(indices, t, b, d)]
+        , v = neighbors[3 * t + edge_of(indices, t, a, d)];
+      if (u != -1 && taken[u])
+        u = -1;
+      if (v != -1 && taken[v])
+        v = -1;
+      if (u == -1 && v == -1)
+        break;
+      if (u == -1 || (v != -1 && left[v] < left[u])) {
+        u = v;
+        strip->back() = a;
+        strip->push_back(d);
+        std::swap(a, b);
+      }
+      const uint32_t *e = indices + 3 * u;
+      uint32_t w = e[0] != b && e[0] != d ? e[0] : e[1] != b && e[1] != d
+        ? e[1] : e[2];
+      strip->push_back(w);
+      take(u);
+      t = u, a = b, b = d, d = w;
+    }
+  }
+  return strip->size();
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "poly2tri.hh"
+#include <cmath>
+
+// internal interface between triangulate() and the algorithms behind it
+
+// the output index buffer, either 32 or 16 bits wide. the triangulators
+// append to it one triangle at a time. triangles past `capacity`, which only
+// come out of input that isn't a simple polygon, are dropped. if there's a
+// `neighbors` buffer, three per triangle as in mesh below, the triangulators
+// that know the adjacency as they go fill it in through link(), and
+// triangulate_polygon() works it out for the others
+struct index_sink
+{
+  uint32_t *indices32;
+  uint16_t *indices16;
+  int32_t *neighbors;
+  size_t count, capacity;
+
+  index_sink(uint32_t *n_indices32, uint16_t *n_indices16, size_t n_capacity
+      , int32_t *n_neighbors = nullptr)
+    : indices32(n_indices32), indices16(n_indices16), neighbors(n_neighbors)
+    , count(0), capacity(n_capacity) {}
+  uint32_t corner(size_t i) const {
+    return indices32 ? indices32[i] : indices16[i];
+  }
+  // makes triangle u the neighbour of triangle t across its edge k, if t made
+  // it into the output
+  void link(int32_t t, int k, int32_t u) {
+    if (t != -1 && (size_t)t < count)
+      neighbors[3 * t + k] = u;
+  }
+  void emit(uint32_t a, uint32_t b, uint32_t c) {
+    if (count == capacity)
+      return;
+    if (indices32) {
+      uint32_t *t = indices32 + 3 * count;
+      t[0] = a, t[1] = b, t[2] = c;
+    } else {
+      uint16_t *t = indices16 + 3 * count;
+      t[0] = (uint16_t)a, t[1] = (uint16_t)b, t[2] = (uint16_t)c;
+    }
+    count++;
+  }
+};
+
+// what the predicates compute in for every type of coordinates
+template <typename T>
+struct wide_type
+{
+  typedef double type;
+};
+
+template <>
+struct wide_type<int32_t>
+{
+  typedef int64_t type;
+};
+
+// the predicates below are exact: a fast floating point evaluation settles
+// the sign whenever it's clear of its error bound, which is all but always,
+// and the rest is left to the adaptive stages in predicates.cc. the bounds
+// are shewchuk's, relative to the sum of the magnitudes of the terms
+static const double epsilon = 1.1102230246251565e-16 // 2^-53
+  , orient_bound = (3 + 16 * epsilon) * epsilon
+  , incircle_bound = (10 + 96 * epsilon) * epsilon;
+
+// predicates.cc
+double orient2d_exact(double ax, double ay, double bx, double by, double cx
+    , double cy, double sum);
+double incircle2d(double ax, double ay, double bx, double by, double cx
+    , double cy, double dx, double dy);
+
+// twice the signed area of triangle abc, positive when it winds
+// counter-clockwise. the sign is exact, the magnitude only as close as it
+// needed to be
+inline double orient2d(double ax, double ay, double bx, double by
+    , double cx, double cy) {
+  double left = (ax - cx) * (by - cy), right = (ay - cy) * (bx - cx)
+    , det = left - right, sum = std::fabs(left) + std::fabs(right);
+  // terms of opposite signs always pass, so there's no need to branch on
+  // them the way shewchuk does. nans pass too, the ear clipper's tombstones
+  // are meant to fail whatever they're compared with
+  if (!(std::fabs(det) < orient_bound * sum))
+    return det;
+  return orient2d_exact(ax, ay, bx, by, cx, cy, sum);
+}
+
+template <typename T>
+inline typename wide_type<T>::type orient(const vec2<T> &a, const vec2<T> &b
+    , const vec2<T> &c) {
+  return orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+// integer coordinates need no filter, 64 bits hold the whole determinant
+template <>
+inline int64_t orient(const vec2<int32_t> &a, const vec2<int32_t> &b
+    , const vec2<int32_t> &c) {
+  return ((int64_t)b.x - a.x) * ((int64_t)c.y - a.y)
+    - ((int64_t)b.y - a.y) * ((int64_t)c.x - a.x);
+}
+
+// positive when d lies inside the circle through the ccw triangle abc. in
+// double for every type, which holds int32_t coordinates exactly
+template <typename T>
+inline double incircle(const vec2<T> &a, const vec2<T> &b, const vec2<T> &c
+    , const vec2<T> &d) {
+  return incircle2d(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+}
+
+// order in which a sweep line moving downwards meets the vertices. ties in y
+// are broken by x so that no two distinct vertices are met at once
+template <typename T>
+inline bool above(const vec2<T> &a, const vec2<T> &b) {
+  return a.y > b.y || (a.y == b.y && a.x < b.x);
+}
+
+// interleaves the bits of two 16-bit numbers
+inline uint32_t morton(uint32_t x, uint32_t y) {
+  x = (x | (x << 8)) & 0x00ff00ff;
+  x = (x | (x << 4)) & 0x0f0f0f0f;
+  x = (x | (x << 2)) & 0x33333333;
+  x = (x | (x << 1)) & 0x55555555;
+  y = (y | (y << 8)) & 0x00ff00ff;
+  y = (y | (y << 4)) & 0x0f0f0f0f;
+  y = (y | (y << 2)) & 0x33333333;
+  y = (y | (y << 1)) & 0x55555555;
+  return x | (y << 1);
+}
+
+// position of (x, y) along the hilbert curve through the 2^16 by 2^16 grid.
+// every step down picks the quadrant, and turns the rest of the point around
+// the way the curve runs through it
+inline uint32_t hilbert(uint32_t x, uint32_t y) {
+  uint32_t d = 0;
+  for (uint32_t s = 1 << 15; s > 0; s >>= 1) {
+    uint32_t rx = (x & s) != 0, ry = (y & s) != 0;
+    d += s * s * ((3 * rx) ^ ry);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = 0xffff - x;
+        y = 0xffff - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+struct diagonal
+{
+  uint32_t a, b;
+};
+
+// the boundary of a polygon, possibly with holes, over one vertex array: the
+// outer ring first and winding ccw, then every hole winding cw, so that the
+// interior is always to the left. edge i runs from vertex i to next[i]
+struct polygon_rings
+{
+  size_t n;
+  // whether the rings are gone around the other way from how they're stored,
+  // for an outer ring that winds cw
+  bool reversed;
+  std::vector<uint32_t> next, prev;
+  // first vertex of every hole
+  std::vector<uint32_t> holes;
+
+  polygon_rings(size_t n_vertices, const uint32_t *hole_starts
+      , size_t hole_count, bool n_reversed = false);
+};
+
+// everything below that takes a vec2<T> is instantiated for float, double
+// and int32_t at the end of the file it's defined in
+
+// poly2tri.cc
+template <typename T>
+size_t triangulate_polygon(const vec2<T> *vertices, size_t n
+    , const uint32_t *hole_starts, size_t holes
+    , const triangulate_options &options, index_sink *out);
+template <typename T>
+bool is_convex(const vec2<T> *vertices, size_t n, bool reversed = false);
+void fan_triangulate(size_t n, index_sink *out, bool reversed = false);
+
+// earclip.cc. `order` lists the vertices around the ring, and may visit a
+// vertex more than once. null means all `n` of them in turn
+template <typename T>
+void earclip_triangulate(const vec2<T> *vertices, const uint32_t *order
+    , size_t n, bool zorder, index_sink *out);
+
+// monotone.cc
+template <typename T>
+void monotone_triangulate(const vec2<T> *vertices
+    , const polygon_rings &rings, index_sink *out);
+template <typename T>
+void triangulate_monotone_pieces(const vec2<T> *vertices
+    , const polygon_rings &rings, const std::vector<diagonal> &diagonals
+    , index_sink *out);
+template <typename T>
+void bridge_holes(const vec2<T> *vertices, const polygon_rings &rings
+    , std::vector<uint32_t> *ring);
+
+// a triangulation with connectivity. neighbors[3 * t + k] is the triangle
+// across the edge from corner k to corner k + 1 of triangle t, or -1 on the
+// boundary
+struct mesh
+{
+  std::vector<uint32_t> corners;
+  std::vector<int32_t> neighbors;
+};
+
+// delaunay.cc
+void build_neighbors(const uint32_t *corners, size_t triangles, size_t n
+    , int32_t *neighbors);
+void link_output(size_t n, index_sink *out);
+template <typename T>
+void legalize(const vec2<T> *vertices, mesh *m);
+template <typename T>
+void cdt_mesh(const vec2<T> *vertices, const polygon_rings &rings, mesh *m);
+template <typename T>
+void cdt_triangulate(const vec2<T> *vertices, const polygon_rings &rings
+    , index_sink *out);
+template <typename T>
+void delaunay_flip(const vec2<T> *vertices, size_t n, index_sink *out);
+
+// seidel.cc
+template <typename T>
+void seidel_triangulate(const vec2<T> *vertices, const polygon_rings &rings
+    , index_sink *out);
+
+// cache.cc. puts triangle order[i] in place i, along with its neighbours if
+// there are any
+void reorder_triangles(uint32_t *indices, int32_t *neighbors
+    , size_t triangles, const std::vector<uint32_t> &order);